@@ -0,0 +1,405 @@
+/*alt.cpp*/
+
+//
+// ALT: A* search with landmarks and the triangle inequality.
+//
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include "alt.h"
+#include "threadpool.h" // defaultThreadCount
+
+static const float INF_FLOAT = std::numeric_limits<float>::infinity();
+
+// float keeps 24 bits; shaving this much off a bound makes up for the
+// rounding of both distances it came from
+static const float ROUNDING_SLACK = 1.0f / (1 << 22);
+
+//
+// parseLandmarkStrategy
+//
+bool parseLandmarkStrategy(const std::string &name, LandmarkStrategy &strategy)
+{
+    if (name == "farthest")
+        strategy = LANDMARKS_FARTHEST;
+    else if (name == "avoid")
+        strategy = LANDMARKS_AVOID;
+    else
+        return false;
+    return true;
+}
+
+//
+// landmarkBudget
+//
+int landmarkBudget(const CompactGraph &G, int count, size_t budgetBytes)
+{
+    size_t perLandmark = (size_t)G.NumVertices() * sizeof(float);
+    if (perLandmark == 0)
+        return 0;
+    return (int)std::min((size_t)count, budgetBytes / perLandmark);
+}
+
+//
+// fullSearch
+//
+// Distances from source to every vertex, as floats.
+//
+static void fullSearch(const CompactGraph &G, int source, SearchWorkspace &W, std::vector<float> &row)
+{
+    dijkstraSearch(G, source, W);
+
+    row.assign(G.NumVertices(), INF_FLOAT);
+    for (int v : W.Touched)
+        if (W.Settled[v])
+            row[v] = (float)W.Dist[v];
+}
+
+//
+// lowerBound
+//
+// Best landmark bound on dist(u, v) from per-landmark rows.
+//
+static float lowerBound(const std::vector<std::vector<float>> &rows, int u, int v)
+{
+    float best = 0.0f;
+    for (const std::vector<float> &row : rows)
+    {
+        if (row[u] == INF_FLOAT || row[v] == INF_FLOAT)
+            continue;
+        best = std::max(best, std::fabs(row[u] - row[v]));
+    }
+    return best;
+}
+
+//
+// selectFarthest
+//
+static std::vector<int> selectFarthest(const CompactGraph &G, const std::vector<int> &candidates,
+                                       int count, int root, SearchWorkspace &W)
+{
+    std::vector<int> chosen;
+    std::vector<double> nearest(G.NumVertices(), INF_DIST); // distance to the closest landmark so far
+
+    // the first landmark is the vertex farthest from a random root
+    dijkstraSearch(G, root, W);
+    int next = root;
+    for (int v : candidates)
+        if (W.Dist[v] > W.Dist[next])
+            next = v;
+
+    while ((int)chosen.size() < count)
+    {
+        chosen.push_back(next);
+        dijkstraSearch(G, next, W);
+
+        next = -1;
+        for (int v : candidates)
+        {
+            nearest[v] = std::min(nearest[v], W.Dist[v]);
+            if (nearest[v] > 0 && (next < 0 || nearest[v] > nearest[next]))
+                next = v;
+        }
+        if (next < 0)
+            break; // every vertex is a landmark
+    }
+    return chosen;
+}
+
+//
+// selectAvoid
+//
+// Also returns the landmarks' distance rows, which it needs anyway.
+//
+static std::vector<int> selectAvoid(const CompactGraph &G, const std::vector<int> &candidates,
+                                    int count, std::mt19937 &random, SearchWorkspace &W,
+                                    std::vector<std::vector<float>> &rows)
+{
+    int n = G.NumVertices();
+    std::vector<int> chosen;
+    std::vector<char> isLandmark(n, 0);
+    std::vector<double> size(n);
+    std::vector<char> covered(n);
+    std::vector<int> byDist;
+    std::vector<int> childOffsets(n + 1);
+    std::vector<int> children;
+
+    while ((int)chosen.size() < count && chosen.size() < candidates.size())
+    {
+        int root = candidates[random() % candidates.size()];
+        dijkstraSearch(G, root, W);
+
+        //
+        // size of a vertex = how badly the landmarks bound the
+        // distance from the root to it, summed over its subtree;
+        // subtrees that already hold a landmark count for nothing:
+        //
+        byDist.clear();
+        for (int v : candidates)
+        {
+            size[v] = W.Dist[v] - lowerBound(rows, root, v);
+            covered[v] = isLandmark[v];
+            byDist.push_back(v);
+        }
+        std::sort(byDist.begin(), byDist.end(), [&W](int a, int b) {
+            return W.Dist[a] > W.Dist[b];
+        });
+
+        std::fill(childOffsets.begin(), childOffsets.end(), 0);
+        for (int v : byDist)
+        {
+            int p = W.Pred[v];
+            if (p < 0)
+                continue;
+            size[p] += size[v];
+            covered[p] = covered[p] || covered[v];
+            childOffsets[p + 1]++;
+        }
+        for (int v = 0; v < n; ++v)
+            childOffsets[v + 1] += childOffsets[v];
+        children.assign(childOffsets[n], 0);
+        std::vector<int> fill(childOffsets.begin(), childOffsets.end() - 1);
+        for (int v : byDist)
+            if (W.Pred[v] >= 0)
+                children[fill[W.Pred[v]]++] = v;
+
+        //
+        // walk down into the heaviest uncovered subtree to a leaf:
+        //
+        int v = root;
+        while (true)
+        {
+            int best = -1;
+            for (int i = childOffsets[v]; i < childOffsets[v + 1]; ++i)
+            {
+                int c = children[i];
+                if (!covered[c] && (best < 0 || size[c] > size[best]))
+                    best = c;
+            }
+            if (best < 0)
+                break;
+            v = best;
+        }
+
+        if (isLandmark[v])
+            continue; // the root's whole tree is covered; try another root
+
+        chosen.push_back(v);
+        isLandmark[v] = 1;
+        rows.push_back(std::vector<float>());
+        fullSearch(G, v, W, rows.back());
+    }
+    return chosen;
+}
+
+//
+// buildLandmarks
+//
+void buildLandmarks(const CompactGraph &G, int count, LandmarkStrategy strategy,
+                    Landmarks &L, int numThreads)
+{
+    L = Landmarks();
+
+    int n = G.NumVertices();
+    std::vector<int> candidates;
+    for (int v = 0; v < n; ++v)
+        if (G.Component.empty() || G.Component[v] == 0)
+            candidates.push_back(v);
+    if (candidates.empty() || count <= 0)
+        return;
+
+    SearchWorkspace W;
+    W.init(n);
+    std::mt19937 random(20120417); // fixed seed: the same map gets the same landmarks
+    int root = candidates[random() % candidates.size()];
+
+    std::vector<std::vector<float>> rows;
+    if (strategy == LANDMARKS_AVOID)
+        L.Vertices = selectAvoid(G, candidates, count, random, W, rows);
+    else
+    {
+        L.Vertices = selectFarthest(G, candidates, count, root, W);
+
+        //
+        // one search per landmark; landmarks are handed out one at a
+        // time and each thread fills only the rows it claimed:
+        //
+        int K = L.K();
+        rows.resize(K);
+        if (numThreads <= 0)
+            numThreads = defaultThreadCount();
+        numThreads = std::min(numThreads, K);
+
+        std::atomic<int> nextLandmark(0);
+        auto worker = [&]() {
+            SearchWorkspace workspace;
+            workspace.init(n);
+
+            int i;
+            while ((i = nextLandmark.fetch_add(1)) < K)
+                fullSearch(G, L.Vertices[i], workspace, rows[i]);
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; ++t)
+            threads.push_back(std::thread(worker));
+        worker();
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    // vertex-major, so a bound reads K adjacent floats
+    int K = L.K();
+    L.Dist.resize((size_t)n * K);
+    for (int i = 0; i < K; ++i)
+        for (int v = 0; v < n; ++v)
+            L.Dist[(size_t)v * K + i] = rows[i][v];
+}
+
+//
+// writeLandmarks
+//
+bool writeLandmarks(const std::string &filename, const CompactGraph &G, const Landmarks &L)
+{
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    auto put = [&out](const void *data, size_t size) {
+        out.write(static_cast<const char *>(data), size);
+    };
+
+    uint32_t header[3] = {1, (uint32_t)G.NumVertices(), (uint32_t)L.K()};
+    uint64_t fingerprint = graphFingerprint(G);
+    put("CMLM", 4);
+    put(header, sizeof(header));
+    put(&fingerprint, sizeof(fingerprint));
+
+    std::vector<int64_t> ids;
+    for (int v : L.Vertices)
+        ids.push_back(G.IDs[v]);
+    put(ids.data(), ids.size() * sizeof(int64_t));
+    put(L.Dist.data(), L.Dist.size() * sizeof(float));
+
+    return (bool)out;
+}
+
+//
+// readLandmarks
+//
+bool readLandmarks(const std::string &filename, const CompactGraph &G, Landmarks &L)
+{
+    L = Landmarks();
+
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+
+    auto get = [&in](void *data, size_t size) {
+        in.read(static_cast<char *>(data), size);
+        return (bool)in;
+    };
+
+    char magic[4];
+    uint32_t header[3];
+    uint64_t fingerprint;
+    if (!get(magic, 4) || std::memcmp(magic, "CMLM", 4) != 0 ||
+        !get(header, sizeof(header)) || !get(&fingerprint, sizeof(fingerprint)))
+        return false;
+    if (header[0] != 1 || header[1] != (uint32_t)G.NumVertices() ||
+        fingerprint != graphFingerprint(G))
+        return false;
+
+    int K = (int)header[2];
+    std::vector<int64_t> ids(K);
+    Landmarks loaded;
+    loaded.Dist.resize((size_t)G.NumVertices() * K);
+    if (!get(ids.data(), ids.size() * sizeof(int64_t)) ||
+        !get(loaded.Dist.data(), loaded.Dist.size() * sizeof(float)))
+        return false;
+
+    for (int64_t id : ids)
+    {
+        int v = G.vertexOf(id);
+        if (v < 0)
+            return false;
+        loaded.Vertices.push_back(v);
+    }
+
+    L = std::move(loaded);
+    return true;
+}
+
+//
+// altSearch
+//
+void altSearch(const CompactGraph &G, const Landmarks &L, int source, int target,
+               SearchWorkspace &W, const Closures *closed)
+{
+    if ((int)W.Dist.size() != G.NumVertices())
+        W.init(G.NumVertices());
+    else
+        W.reset();
+
+    int K = L.K();
+    const float *toTarget = &L.Dist[(size_t)target * K];
+
+    auto bound = [&](int v) {
+        const float *toV = &L.Dist[(size_t)v * K];
+        float best = 0.0f;
+        for (int i = 0; i < K; ++i)
+        {
+            if (toTarget[i] == INF_FLOAT || toV[i] == INF_FLOAT)
+                continue;
+            float d = std::fabs(toTarget[i] - toV[i]) - ROUNDING_SLACK * (toTarget[i] + toV[i]);
+            best = std::max(best, d);
+        }
+        return (double)best;
+    };
+
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+    queue.clear();
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    queue.update(source, bound(source));
+
+    //
+    // keys are Dist + bound.  The rounding slack can make the bound a
+    // hair inconsistent, so a vertex whose distance still improves
+    // after it was settled is simply queued again:
+    //
+    while (!queue.empty())
+    {
+        int u = queue.pop().second;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+
+        if (u == target)
+            break;
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            if (closed && closed->blocks(e, v))
+                continue;
+            double alt = W.Dist[u] + G.Weights[e];
+            if (alt < W.Dist[v])
+            {
+                W.touch(v);
+                W.Dist[v] = alt;
+                W.Pred[v] = u;
+                queue.update(v, alt + bound(v));
+            }
+        }
+    }
+}
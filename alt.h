@@ -0,0 +1,120 @@
+/*alt.h*/
+
+//
+// ALT: A* search with landmarks and the triangle inequality.
+//
+// A straight-line heuristic knows nothing about fences, rail lines or
+// buildings in the way, so on a campus it is a weak lower bound and
+// A* with it settles nearly as much as Dijkstra.  ALT instead picks a
+// few landmark vertices and stores the exact distance from each of
+// them to every vertex.  For a landmark L the triangle inequality
+// gives
+//
+//   dist(v, t) >= |dist(L, t) - dist(L, v)|
+//
+// (footways are two-way, so dist(L, v) = dist(v, L)), and the best of
+// these bounds over all landmarks steers the search toward t.
+// Landmarks "behind" the start or "beyond" the target give bounds
+// that are nearly exact.
+//
+// Landmark selection:
+//
+//   LANDMARKS_FARTHEST  each new landmark is the vertex farthest from
+//                       all the ones picked so far
+//   LANDMARKS_AVOID     grows a shortest-path tree from a random root
+//                       and descends into the subtree whose distances
+//                       the current landmarks bound worst (and that
+//                       holds no landmark yet), taking the leaf it
+//                       reaches
+//
+// Landmarks are picked in the largest component.  Selection is
+// sequential, since every pick depends on the distances from the
+// earlier ones; the distance table is then filled with one search per
+// landmark, in parallel.  The table (vertex-major: the K distances of
+// a vertex are adjacent) can be written to a file and read back on
+// the next start, as long as the graph and the landmark count are the
+// same.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+#include "search.h"
+
+enum LandmarkStrategy
+{
+    LANDMARKS_FARTHEST,
+    LANDMARKS_AVOID
+};
+
+struct Landmarks
+{
+    std::vector<int> Vertices; // K landmark vertices
+    std::vector<float> Dist;   // N*K, Dist[v*K + i] = dist(landmark i, v); infinity if unreachable
+
+    int K() const
+    {
+        return (int)this->Vertices.size();
+    }
+
+    bool empty() const
+    {
+        return this->Vertices.empty();
+    }
+
+    size_t bytes() const
+    {
+        return this->Dist.size() * sizeof(float);
+    }
+};
+
+//
+// parseLandmarkStrategy
+//
+// "farthest" or "avoid"; returns false for anything else.
+//
+bool parseLandmarkStrategy(const std::string &name, LandmarkStrategy &strategy);
+
+//
+// landmarkBudget
+//
+// The number of landmarks (at most count) whose table fits in
+// budgetBytes for G.
+//
+int landmarkBudget(const CompactGraph &G, int count, size_t budgetBytes);
+
+//
+// buildLandmarks
+//
+// Picks count landmarks with the given strategy and fills their
+// distance table.  numThreads <= 0 means one per core.
+//
+void buildLandmarks(const CompactGraph &G, int count, LandmarkStrategy strategy,
+                    Landmarks &L, int numThreads = 0);
+
+//
+// writeLandmarks, readLandmarks
+//
+// Binary file: "CMLM", uint32 version (1), uint32 N, uint32 K,
+// uint64 fingerprint of the graph, K int64 landmark OSM ids, then the
+// N*K float32 table.  readLandmarks returns false (and leaves L
+// empty) if the file is missing, malformed, or was built for a
+// different graph.
+//
+bool writeLandmarks(const std::string &filename, const CompactGraph &G, const Landmarks &L);
+bool readLandmarks(const std::string &filename, const CompactGraph &G, Landmarks &L);
+
+//
+// altSearch
+//
+// A* from source to target with the landmark bound, in W (reset
+// first).  On return W.Settled[target] tells whether target was
+// reached, and Dist/Pred hold the path to it as for dijkstraSearch.
+// W.NumSettled counts the vertices the search settled.  With closed
+// it avoids the closures; the bound stays valid (see closures.h).
+//
+void altSearch(const CompactGraph &G, const Landmarks &L, int source, int target,
+               SearchWorkspace &W, const Closures *closed = nullptr);
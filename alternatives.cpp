@@ -0,0 +1,405 @@
+/*alternatives.cpp*/
+
+//
+// Alternative routes between two vertices.
+//
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+
+#include "alternatives.h"
+
+//
+// edgeWeight
+//
+// Length of the shortest edge u -> v.
+//
+static double edgeWeight(const CompactGraph &G, int u, int v)
+{
+    double best = INF_DIST;
+    for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        if (G.Targets[e] == v)
+            best = std::min(best, G.Weights[e]);
+    return best;
+}
+
+//
+// appendTreePath
+//
+// v and the vertices after it on the way to the root of the tree in W,
+// whose Pred points toward the root.
+//
+static void appendTreePath(const SearchWorkspace &W, int v, std::vector<int> &path)
+{
+    for (; v != -1; v = W.Pred[v])
+        path.push_back(v);
+}
+
+//
+// isLoopless
+//
+static bool isLoopless(std::vector<int> path)
+{
+    std::sort(path.begin(), path.end());
+    return std::adjacent_find(path.begin(), path.end()) == path.end();
+}
+
+namespace
+{
+struct Candidate
+{
+    std::vector<int> Path;
+    double Miles;
+    int Deviation; // index of the vertex where it left its parent
+};
+
+//
+// Yen's algorithm over one source / target pair.
+//
+class YenSearch
+{
+private:
+    const CompactGraph &G;
+    int source;
+    int target;
+    SearchWorkspace &T; // target's tree, Pred toward the target
+    SearchWorkspace &S;
+    Alternatives &A;
+    const Closures *closed;
+    double radius; // T settled everything closer to the target
+
+    //
+    // toTarget
+    //
+    // Lower bound on the distance from v to the target: exact where T
+    // settled v, and no vertex it left unsettled is any closer than
+    // the last distance it settled.
+    //
+    double toTarget(int v) const
+    {
+        return this->T.Settled[v] ? this->T.Dist[v] : this->radius;
+    }
+
+    //
+    // treeSpur
+    //
+    // The spur path from spur as a tree path, if the best first step
+    // leads onto one that avoids the root path (flagged in S.Marked)
+    // and spur itself; returns false if a search is needed.
+    //
+    bool treeSpur(int spur, const std::vector<int> &forbidden, std::vector<int> &path, double &miles)
+    {
+        int best = -1;
+        double bound = INF_DIST;
+        for (int e = this->G.Offsets[spur]; e < this->G.Offsets[spur + 1]; ++e)
+        {
+            int v = this->G.Targets[e];
+            if (v == spur || this->S.Marked[v] || (this->closed && this->closed->blocks(e, v)) ||
+                std::find(forbidden.begin(), forbidden.end(), v) != forbidden.end())
+                continue;
+            double d = this->G.Weights[e] + this->toTarget(v);
+            if (d < bound)
+            {
+                bound = d;
+                best = v;
+            }
+        }
+        if (best < 0 || !this->T.Settled[best])
+            return false;
+
+        for (int v = best; v != -1; v = this->T.Pred[v])
+            if (v == spur || this->S.Marked[v])
+                return false;
+
+        path.push_back(spur);
+        appendTreePath(this->T, best, path);
+        miles = bound;
+        return true;
+    }
+
+    //
+    // spurSearch
+    //
+    // A* from spur to the target in S, skipping the vertices flagged in
+    // S.Marked and the first steps in forbidden.  Like altSearch it
+    // requeues a vertex whose distance improves after it was settled.
+    //
+    bool spurSearch(int spur, const std::vector<int> &forbidden, std::vector<int> &path, double &miles)
+    {
+        SearchWorkspace &S = this->S;
+        IndexedDaryHeap<4> &queue = S.DaryQueue;
+        queue.clear();
+        S.touch(spur);
+        S.Dist[spur] = 0.0;
+        queue.update(spur, this->toTarget(spur));
+
+        bool found = false;
+        while (!queue.empty())
+        {
+            int u = queue.pop().second;
+            S.Settled[u] = 1;
+            S.NumSettled++;
+            if (u == this->target)
+            {
+                found = true;
+                break;
+            }
+
+            for (int e = this->G.Offsets[u]; e < this->G.Offsets[u + 1]; ++e)
+            {
+                int v = this->G.Targets[e];
+                if (S.Marked[v] || v == spur || (this->closed && this->closed->blocks(e, v)) ||
+                    (u == spur && std::find(forbidden.begin(), forbidden.end(), v) != forbidden.end()))
+                    continue;
+                double alt = S.Dist[u] + this->G.Weights[e];
+                if (alt < S.Dist[v])
+                {
+                    S.touch(v);
+                    S.Dist[v] = alt;
+                    S.Pred[v] = u;
+                    queue.update(v, alt + this->toTarget(v));
+                }
+            }
+        }
+
+        this->A.Searches++;
+        this->A.Settled += S.NumSettled;
+        if (!found)
+            return false;
+
+        path = traceCompactPath(S.Pred, spur, this->target);
+        miles = S.Dist[this->target];
+        return true;
+    }
+
+public:
+    YenSearch(const CompactGraph &graph, int s, int t, SearchWorkspace &tree,
+              SearchWorkspace &spur, Alternatives &alternatives, const Closures *closures)
+        : G(graph), T(tree), S(spur), A(alternatives)
+    {
+        this->closed = closures;
+        this->source = s;
+        this->target = t;
+        this->radius = 0.0;
+    }
+
+    void run(int k)
+    {
+        dijkstraSearch(this->G, this->target, this->T, std::vector<int>(1, this->source),
+                       QUEUE_DARY, this->closed);
+        this->A.Searches++;
+        this->A.Settled += this->T.NumSettled;
+        if (!this->T.Settled[this->source] || k <= 0)
+            return;
+        this->radius = this->T.Dist[this->source];
+
+        if ((int)this->S.Dist.size() != this->G.NumVertices())
+            this->S.init(this->G.NumVertices());
+
+        std::vector<Candidate> accepted(1);
+        appendTreePath(this->T, this->source, accepted[0].Path);
+        accepted[0].Miles = this->T.Dist[this->source];
+        accepted[0].Deviation = 0;
+
+        std::vector<Candidate> candidates;
+        std::set<std::vector<int>> seen;
+        seen.insert(accepted[0].Path);
+
+        while ((int)accepted.size() < k)
+        {
+            const Candidate last = accepted.back();
+
+            double rootMiles = 0.0;
+            for (int j = 0; j < last.Deviation; ++j)
+                rootMiles += edgeWeight(this->G, last.Path[j], last.Path[j + 1]);
+
+            for (int j = last.Deviation; j + 1 < (int)last.Path.size(); ++j)
+            {
+                int spur = last.Path[j];
+
+                // first steps taken by accepted paths with the same root
+                std::vector<int> forbidden;
+                for (const Candidate &p : accepted)
+                    if ((int)p.Path.size() > j + 1 &&
+                        std::equal(last.Path.begin(), last.Path.begin() + j + 1, p.Path.begin()))
+                        forbidden.push_back(p.Path[j + 1]);
+
+                // the root path is off limits (S.Marked, cleared by reset)
+                this->S.reset();
+                for (int r = 0; r < j; ++r)
+                {
+                    this->S.touch(last.Path[r]);
+                    this->S.Marked[last.Path[r]] = 1;
+                }
+
+                std::vector<int> spurPath;
+                double spurMiles;
+                bool found;
+                if (this->treeSpur(spur, forbidden, spurPath, spurMiles))
+                {
+                    this->A.TreeSpurs++;
+                    found = true;
+                }
+                else
+                    found = this->spurSearch(spur, forbidden, spurPath, spurMiles);
+
+                if (found)
+                {
+                    Candidate c;
+                    c.Path.assign(last.Path.begin(), last.Path.begin() + j);
+                    c.Path.insert(c.Path.end(), spurPath.begin(), spurPath.end());
+                    c.Miles = rootMiles + spurMiles;
+                    c.Deviation = j;
+                    if (seen.insert(c.Path).second)
+                        candidates.push_back(std::move(c));
+                }
+
+                rootMiles += edgeWeight(this->G, spur, last.Path[j + 1]);
+            }
+
+            if (candidates.empty())
+                break;
+
+            auto shortest = std::min_element(candidates.begin(), candidates.end(),
+                                             [](const Candidate &a, const Candidate &b) {
+                                                 return a.Miles < b.Miles;
+                                             });
+            accepted.push_back(std::move(*shortest));
+            *shortest = std::move(candidates.back());
+            candidates.pop_back();
+        }
+        this->S.reset();
+
+        for (Candidate &c : accepted)
+            this->A.Routes.push_back(AlternativeRoute{std::move(c.Path), c.Miles});
+    }
+};
+}
+
+//
+// kShortestPaths
+//
+void kShortestPaths(const CompactGraph &G, int source, int target, int k,
+                    SearchWorkspace &T, SearchWorkspace &S, Alternatives &A,
+                    const Closures *closed)
+{
+    A = Alternatives();
+    YenSearch yen(G, source, target, T, S, A, closed);
+    yen.run(k);
+}
+
+//
+// plateauAlternatives
+//
+void plateauAlternatives(const CompactGraph &G, int source, int target, int k,
+                         SearchWorkspace &F, SearchWorkspace &B, Alternatives &A,
+                         const Closures *closed, double maxStretch, double maxShared)
+{
+    A = Alternatives();
+    if (source == target)
+    {
+        A.Routes.push_back(AlternativeRoute{std::vector<int>(1, source), 0.0});
+        return;
+    }
+
+    dijkstraSearch(G, target, B, std::vector<int>(1, source), QUEUE_DARY, closed);
+    A.Searches++;
+    A.Settled += B.NumSettled;
+    if (!B.Settled[source] || k <= 0)
+        return;
+    double limit = maxStretch * B.Dist[source];
+
+    // both trees out to the longest route that could qualify
+    boundedSearch(G, source, limit, F, closed);
+    A.Settled += F.NumSettled;
+    boundedSearch(G, target, limit, B, closed);
+    A.Settled += B.NumSettled;
+    A.Searches += 2;
+
+    //
+    // plateaus: maximal chains of edges u -> v in both trees, i.e.
+    // F.Pred[v] == u and B.Pred[u] == v.  Each is (first, last, length).
+    //
+    struct Plateau
+    {
+        int First;
+        int Last;
+        double Length;
+        double Miles;
+    };
+    std::vector<Plateau> plateaus;
+    auto plateauEdge = [&](int u) {
+        int v = B.Pred[u];
+        return v >= 0 && F.Settled[v] && F.Pred[v] == u;
+    };
+    for (int a : F.Touched)
+    {
+        if (!F.Settled[a] || !B.Settled[a] || !plateauEdge(a))
+            continue;
+        int p = F.Pred[a];
+        if (p >= 0 && B.Settled[p] && B.Pred[p] == a)
+            continue; // not the first vertex of its plateau
+
+        int last = a;
+        while (plateauEdge(last))
+            last = B.Pred[last];
+        double miles = F.Dist[last] + B.Dist[last];
+        if (miles <= limit)
+            plateaus.push_back(Plateau{a, last, F.Dist[last] - F.Dist[a], miles});
+    }
+    std::sort(plateaus.begin(), plateaus.end(), [](const Plateau &x, const Plateau &y) {
+        if (x.Length != y.Length)
+            return x.Length > y.Length;
+        return x.Miles < y.Miles;
+    });
+
+    // edges of the routes taken so far, as (min, max) vertex pairs
+    std::vector<std::set<std::pair<int, int>>> taken;
+    for (const Plateau &plateau : plateaus)
+    {
+        if ((int)A.Routes.size() >= k)
+            break;
+
+        AlternativeRoute route;
+        route.Path = traceCompactPath(F.Pred, source, plateau.First);
+        route.Path.pop_back();
+        appendTreePath(B, plateau.First, route.Path);
+        route.Miles = plateau.Miles;
+        if (!isLoopless(route.Path))
+            continue;
+
+        std::set<std::pair<int, int>> edges;
+        for (size_t i = 0; i + 1 < route.Path.size(); ++i)
+            edges.insert(std::make_pair(std::min(route.Path[i], route.Path[i + 1]),
+                                        std::max(route.Path[i], route.Path[i + 1])));
+
+        bool distinct = true;
+        for (const std::set<std::pair<int, int>> &other : taken)
+        {
+            double shared = 0.0;
+            for (size_t i = 0; i + 1 < route.Path.size(); ++i)
+                if (other.count(std::make_pair(std::min(route.Path[i], route.Path[i + 1]),
+                                               std::max(route.Path[i], route.Path[i + 1]))))
+                    shared += edgeWeight(G, route.Path[i], route.Path[i + 1]);
+            if (shared > maxShared * route.Miles)
+            {
+                distinct = false;
+                break;
+            }
+        }
+        if (!distinct)
+            continue;
+
+        taken.push_back(std::move(edges));
+        A.Routes.push_back(std::move(route));
+    }
+
+    // the plateau of the shortest path is the longest one, but ties
+    // in length can reorder them; keep the promise of shortest first
+    std::stable_sort(A.Routes.begin(), A.Routes.end(),
+                     [](const AlternativeRoute &x, const AlternativeRoute &y) {
+                         return x.Miles < y.Miles;
+                     });
+}
@@ -0,0 +1,83 @@
+/*alternatives.h*/
+
+//
+// Alternative routes between two vertices.
+//
+// kShortestPaths is Yen's algorithm for the k shortest loopless paths,
+// with Lawler's refinement (a path only spurs from the point where it
+// left its parent).  Every spur search runs toward the same target, so
+// one search from the target, stopped once it reaches the source, is
+// shared by all of them:
+//
+//   - its distances are a lower bound on the distance to the target
+//     in any graph with vertices or edges removed, so spur searches
+//     are A* searches guided by them and settle little more than the
+//     path they find, and
+//   - if the best first step out of a spur vertex continues along the
+//     target's tree without touching the root path, that tree path is
+//     the spur path and no search is needed at all.
+//
+// plateauAlternatives is the plateau method: one tree grown from each
+// end; stretches where the two trees share edges ("plateaus") are
+// routes that are locally shortest, and the longest plateaus give the
+// most distinct alternatives.  All routes come from three searches.
+// The routes are not the k shortest, but they differ from each other
+// far more than Yen's, which often differ by a single detour.
+//
+// Both report the searches they ran, so the cost of an alternative can
+// be compared with the one search that finds the shortest route, and
+// both take closures (closures.h) to route around.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "compactgraph.h"
+#include "search.h"
+
+struct AlternativeRoute
+{
+    std::vector<int> Path; // dense vertices, source to target
+    double Miles;
+};
+
+struct Alternatives
+{
+    std::vector<AlternativeRoute> Routes; // shortest first
+    int Searches;                         // graph searches run
+    int TreeSpurs;                        // spur paths read off the target's tree
+    long long Settled;                    // vertices settled over all searches
+
+    Alternatives()
+    {
+        Searches = 0;
+        TreeSpurs = 0;
+        Settled = 0;
+    }
+};
+
+//
+// kShortestPaths
+//
+// Fills A with up to k loopless paths from source to target in order
+// of length (fewer if there are no more).  T keeps the target's tree
+// and S is used for spur searches, so they must be different
+// workspaces.
+//
+void kShortestPaths(const CompactGraph &G, int source, int target, int k,
+                    SearchWorkspace &T, SearchWorkspace &S, Alternatives &A,
+                    const Closures *closed = nullptr);
+
+//
+// plateauAlternatives
+//
+// Fills A with the shortest path and up to k-1 alternatives from the
+// plateau method.  Alternatives are at most maxStretch times as long as
+// the shortest path and share at most maxShared of their length with
+// any route before them.  F and B hold the forward and backward trees.
+//
+void plateauAlternatives(const CompactGraph &G, int source, int target, int k,
+                         SearchWorkspace &F, SearchWorkspace &B, Alternatives &A,
+                         const Closures *closed = nullptr,
+                         double maxStretch = 1.25, double maxShared = 0.7);
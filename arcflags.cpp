@@ -0,0 +1,179 @@
+/*arcflags.cpp*/
+
+//
+// Arc flags over one level of a cell partition.
+//
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include "arcflags.h"
+#include "threadpool.h"
+
+//
+// arcFlagLevel
+//
+int arcFlagLevel(const Partition &P, int maxCells)
+{
+    for (int level = 0; level < P.NumLevels(); ++level)
+        if (P.NumCells[level] <= maxCells)
+            return level;
+    return -1;
+}
+
+//
+// flagTree
+//
+// Grows the shortest path tree of boundary vertex b and flags each
+// tree edge, pointing toward b, for b's cell.
+//
+static void flagTree(const CompactGraph &G, const ArcFlags &F, int b, SearchWorkspace &W,
+                     std::vector<uint64_t> &flags)
+{
+    dijkstraSearch(G, b, W);
+
+    int cell = F.Cell[b];
+    uint64_t bit = (uint64_t)1 << (cell % 64);
+    for (int u : W.Touched)
+    {
+        int p = W.Pred[u];
+        if (p < 0)
+            continue;
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            if (G.Targets[e] == p)
+            {
+                flags[(size_t)e * F.Words + cell / 64] |= bit;
+                break;
+            }
+    }
+}
+
+//
+// buildArcFlags
+//
+void buildArcFlags(const CompactGraph &G, const Partition &P, int level, ArcFlags &F,
+                   int numThreads)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int n = G.NumVertices();
+    int m = G.NumEdges();
+    F = ArcFlags();
+    F.Level = level;
+    F.NumCells = P.NumCells[level];
+    F.Words = (F.NumCells + 63) / 64;
+    F.Cell = P.Cells[level];
+
+    // inside its cell, every edge may be on the way to a target there
+    std::vector<uint64_t> flags((size_t)m * F.Words, 0);
+    std::vector<int> boundary;
+    for (int u = 0; u < n; ++u)
+    {
+        bool isBoundary = false;
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int cell = F.Cell[G.Targets[e]];
+            if (cell == F.Cell[u])
+                flags[(size_t)e * F.Words + cell / 64] |= (uint64_t)1 << (cell % 64);
+            else
+                isBoundary = true;
+        }
+        if (isBoundary)
+            boundary.push_back(u);
+    }
+
+    // one tree per boundary vertex; each worker flags its own copy
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    numThreads = std::max(1, std::min(numThreads, (int)boundary.size()));
+    std::vector<SearchWorkspace> workspaces(numThreads);
+    std::vector<std::vector<uint64_t>> local(numThreads - 1, std::vector<uint64_t>(flags.size(), 0));
+
+    if (numThreads == 1)
+    {
+        for (int b : boundary)
+            flagTree(G, F, b, workspaces[0], flags);
+    }
+    else
+    {
+        WorkStealingPool pool(numThreads);
+        pool.parallelFor(boundary.size(), 4, [&](size_t begin, size_t end, int worker) {
+            std::vector<uint64_t> &mine = worker == 0 ? flags : local[worker - 1];
+            for (size_t i = begin; i < end; ++i)
+                flagTree(G, F, boundary[i], workspaces[worker], mine);
+        });
+        for (const std::vector<uint64_t> &other : local)
+            for (size_t i = 0; i < flags.size(); ++i)
+                flags[i] |= other[i];
+    }
+
+    // store each distinct flag vector once
+    int words = F.Words;
+    auto flagsOf = [&flags, words](int e) { return flags.data() + (size_t)e * words; };
+    std::vector<int> edges(m);
+    for (int e = 0; e < m; ++e)
+        edges[e] = e;
+    std::sort(edges.begin(), edges.end(), [&](int a, int b) {
+        return std::lexicographical_compare(flagsOf(a), flagsOf(a) + words, flagsOf(b), flagsOf(b) + words);
+    });
+
+    F.EdgePattern.resize(m);
+    for (int i = 0; i < m; ++i)
+    {
+        int e = edges[i];
+        if (i == 0 || !std::equal(flagsOf(e), flagsOf(e) + words, flagsOf(edges[i - 1])))
+            F.Patterns.insert(F.Patterns.end(), flagsOf(e), flagsOf(e) + words);
+        F.EdgePattern[e] = (uint32_t)(F.NumPatterns() - 1);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    F.BuildSeconds = elapsed.count();
+}
+
+//
+// arcFlagSearch
+//
+void arcFlagSearch(const CompactGraph &G, const ArcFlags &F, int source, int target,
+                   SearchWorkspace &W)
+{
+    if ((int)W.Dist.size() != G.NumVertices())
+        W.init(G.NumVertices());
+    else
+        W.reset();
+
+    int cell = F.Cell[target];
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+    queue.clear();
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    queue.update(source, 0.0);
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+        int u = current.second;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+
+        if (u == target)
+            break;
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            if (!F.flagged(e, cell))
+                continue;
+            int v = G.Targets[e];
+            double alt = current.first + G.Weights[e];
+            if (alt < W.Dist[v])
+            {
+                W.touch(v);
+                W.Dist[v] = alt;
+                W.Pred[v] = u;
+                queue.update(v, alt);
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*arcflags.h*/
+
+//
+// Arc flags: for every edge, the cells of one partition level
+// (partition.h) it starts a shortest path toward.
+//
+// A query toward a vertex in cell c only relaxes the edges flagged
+// for c, so from far away it follows the few edges that lead into c
+// and prunes the rest of the map.  That pays off most when many
+// queries head for the same few cells, and costs a search per boundary
+// vertex to precompute: every cell's boundary vertices grow a shortest
+// path tree over the whole graph, and every edge of those trees is
+// flagged for the cell.  Edges inside a cell are flagged for it too.
+// Footways are two-way, so a tree grown from a boundary vertex is also
+// the tree of shortest paths into it.
+//
+// The flags of an edge are a bit vector of Words 64-bit words.  Most
+// edges far from any boundary share their vector with many others, so
+// the distinct vectors are stored once, in Patterns, and each edge
+// keeps only the index of its own.
+//
+// Lauther, "An Extremely Fast, Exact Algorithm for Finding Shortest
+// Paths in Static Networks with Geographical Background" (2004).
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "compactgraph.h"
+#include "partition.h"
+#include "search.h"
+
+struct ArcFlags
+{
+    int Level;                         // partition level the cells come from
+    int NumCells;
+    int Words;                         // 64-bit words per flag vector
+    std::vector<int> Cell;             // vertex -> cell
+    std::vector<uint64_t> Patterns;    // the distinct flag vectors, Words each
+    std::vector<uint32_t> EdgePattern; // edge -> its vector in Patterns
+    double BuildSeconds;
+
+    ArcFlags()
+    {
+        Level = -1;
+        NumCells = 0;
+        Words = 0;
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->EdgePattern.empty();
+    }
+
+    int NumPatterns() const
+    {
+        return this->Words > 0 ? (int)(this->Patterns.size() / this->Words) : 0;
+    }
+
+    size_t bytes() const
+    {
+        return this->Cell.size() * sizeof(int) + this->Patterns.size() * sizeof(uint64_t) +
+               this->EdgePattern.size() * sizeof(uint32_t);
+    }
+
+    bool flagged(int e, int cell) const
+    {
+        uint64_t word = this->Patterns[(size_t)this->EdgePattern[e] * this->Words + cell / 64];
+        return (word >> (cell % 64)) & 1;
+    }
+};
+
+//
+// arcFlagLevel
+//
+// The finest level of P with at most maxCells cells, -1 if none.
+//
+int arcFlagLevel(const Partition &P, int maxCells);
+
+//
+// buildArcFlags
+//
+// Flags every edge of G for the cells of the given level of P, on
+// numThreads threads (<= 0: one per core).
+//
+void buildArcFlags(const CompactGraph &G, const Partition &P, int level, ArcFlags &F,
+                   int numThreads = 0);
+
+//
+// arcFlagSearch
+//
+// Dijkstra from source to target over the edges flagged for target's
+// cell, in W (reset first).  On return W.Settled[target] tells whether
+// target was reached, and Dist/Pred hold the path to it as for
+// dijkstraSearch.
+//
+void arcFlagSearch(const CompactGraph &G, const ArcFlags &F, int source, int target,
+                   SearchWorkspace &W);
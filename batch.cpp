@@ -0,0 +1,198 @@
+/*batch.cpp*/
+
+//
+// Non-interactive batch routing.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "batch.h"
+#include "threadpool.h"
+
+// queries are read, answered and written this many at a time
+static const size_t BATCH_CHUNK = 4096;
+
+// queries per pool task: small enough to balance, large enough that
+// scheduling stays cheap next to the searches
+static const size_t BATCH_GRAIN = 16;
+
+//
+// readRouteQueries
+//
+int readRouteQueries(std::istream &input, std::vector<RouteQuery> &queries, size_t max)
+{
+    int malformed = 0;
+    std::string line;
+    size_t count = 0;
+
+    while (count < max && std::getline(input, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos)
+        {
+            malformed++;
+            continue;
+        }
+
+        RouteQuery q;
+        q.From = line.substr(0, tab);
+        q.To = line.substr(tab + 1);
+        queries.push_back(q);
+        count++;
+    }
+    return malformed;
+}
+
+//
+// writeRouteResult
+//
+void writeRouteResult(BufferedWriter &out, const CampusMap &campus, size_t index,
+                      const RouteResult &r, bool withPath)
+{
+    const CompactGraph &G = campus.Graph;
+
+    out.put((long long)index).put('\t').put(routeStatusName(r.Status)).put('\t');
+    if (r.Start >= 0)
+        out.put(G.IDs[r.Start]);
+    out.put('\t');
+    if (r.Dest >= 0)
+        out.put(G.IDs[r.Dest]);
+    out.put('\t');
+
+    if (r.Status == ROUTE_OK)
+    {
+        out.put(r.Miles);
+        out.put('\t');
+        if (withPath)
+        {
+            for (size_t i = 0; i < r.Path.size(); ++i)
+            {
+                if (i > 0)
+                    out.put(' ');
+                out.put(G.IDs[r.Path[i]]);
+            }
+        }
+    }
+    else
+        out.put('\t');
+    out.put('\n');
+}
+
+//
+// reportBatchStats
+//
+void reportBatchStats(std::ostream &log, std::vector<double> &micros, double seconds)
+{
+    log << "batch: " << micros.size() << " queries in " << seconds << " s";
+    if (seconds > 0)
+        log << " (" << micros.size() / seconds << " queries/s)";
+    log << std::endl;
+
+    if (micros.empty())
+        return;
+
+    std::sort(micros.begin(), micros.end());
+    auto percentile = [&micros](double p) {
+        size_t i = (size_t)(p * (micros.size() - 1) + 0.5);
+        return micros[i];
+    };
+
+    log << "latency (us): p50 " << percentile(0.50)
+        << ", p90 " << percentile(0.90)
+        << ", p99 " << percentile(0.99)
+        << ", p99.9 " << percentile(0.999)
+        << ", max " << micros.back() << std::endl;
+}
+
+//
+// runBatch
+//
+int runBatch(const CampusMap &campus, std::istream &input, std::FILE *output,
+             std::ostream &log, const BatchOptions &options)
+{
+    BufferedWriter out(output);
+
+    int numThreads = options.Threads > 0 ? options.Threads : defaultThreadCount();
+    std::unique_ptr<WorkStealingPool> pool;
+    if (numThreads > 1)
+        pool.reset(new WorkStealingPool(numThreads));
+
+    std::vector<SearchWorkspace> workspaces(numThreads);
+    for (SearchWorkspace &W : workspaces)
+        W.init(campus.Graph.NumVertices());
+
+    std::vector<RouteQuery> queries;
+    std::vector<RouteResult> results;
+    std::vector<double> micros;
+    long long settled = 0;
+    size_t searched = 0;
+    size_t index = 0;
+    int malformed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (true)
+    {
+        queries.clear();
+        malformed += readRouteQueries(input, queries, BATCH_CHUNK);
+        if (queries.empty())
+            break;
+        for (RouteQuery &q : queries)
+        {
+            q.Queue = options.Queue;
+            q.WithPath = options.WithPaths;
+        }
+
+        results.resize(queries.size());
+        if (pool)
+        {
+            pool->parallelFor(queries.size(), BATCH_GRAIN, [&](size_t begin, size_t end, int worker) {
+                for (size_t i = begin; i < end; ++i)
+                    routeQuery(campus, queries[i], workspaces[worker], results[i]);
+            });
+        }
+        else
+        {
+            for (size_t i = 0; i < queries.size(); ++i)
+                routeQuery(campus, queries[i], workspaces[0], results[i]);
+        }
+
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            writeRouteResult(out, campus, index++, results[i], options.WithPaths);
+            micros.push_back(results[i].Micros);
+            if (results[i].Settled > 0)
+            {
+                settled += results[i].Settled;
+                searched++;
+            }
+        }
+    }
+    out.flush();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (malformed > 0)
+        log << "batch: skipped " << malformed << " malformed line(s)" << std::endl;
+    reportBatchStats(log, micros, elapsed.count());
+
+    // how much of the graph the searches looked at, to compare
+    // search strategies (e.g. plain Dijkstra against --alt)
+    if (searched > 0)
+    {
+        double average = (double)settled / searched;
+        log << "search: " << average << " vertices settled per query ("
+            << 100.0 * average / campus.Graph.NumVertices() << "% of the graph)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*batch.h*/
+
+//
+// Non-interactive batch routing.
+//
+// Input: one query per line, "start<TAB>destination", where each side
+// is a building (abbreviation, name or partial name) or an OSM node
+// id.  Blank lines and lines starting with '#' are skipped.
+//
+// Output: one tab-separated line per query, in input order:
+//
+//   index  status  start-node  dest-node  miles  path
+//
+// where status is ok, unreachable, start-not-found or dest-not-found,
+// and path is the space-separated node ids (empty unless ok and paths
+// were requested).  Throughput and latency percentiles go to the log
+// stream.
+//
+// With more than one thread, queries are answered on a work-stealing
+// pool: every worker has its own SearchWorkspace and they all share
+// the read-only CampusMap.  Results are still written in input order.
+//
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "campus.h"
+#include "router.h"
+#include "writer.h"
+
+struct BatchOptions
+{
+    bool WithPaths;
+    int Threads;     // <= 0 means one per core
+    QueueKind Queue; // priority queue used by every search
+
+    BatchOptions()
+    {
+        WithPaths = true;
+        Threads = 1;
+        Queue = QUEUE_DARY;
+    }
+};
+
+//
+// readRouteQueries
+//
+// Appends up to max queries from the input to queries (fewer at end
+// of input); returns the number of malformed lines skipped.
+//
+int readRouteQueries(std::istream &input, std::vector<RouteQuery> &queries, size_t max);
+
+//
+// writeRouteResult
+//
+void writeRouteResult(BufferedWriter &out, const CampusMap &campus, size_t index,
+                      const RouteResult &r, bool withPath);
+
+//
+// reportBatchStats
+//
+// Prints throughput and per-query latency percentiles.
+//
+void reportBatchStats(std::ostream &log, std::vector<double> &micros, double seconds);
+
+//
+// runBatch
+//
+// Reads queries from input, answers them and writes the results to
+// output.  Returns 0 on success.
+//
+int runBatch(const CampusMap &campus, std::istream &input, std::FILE *output,
+             std::ostream &log, const BatchOptions &options);
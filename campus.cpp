@@ -0,0 +1,299 @@
+/*campus.cpp*/
+
+//
+// Loading a map and resolving locations on it.
+//
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+
+#include "tinyxml2.h"
+#include "campus.h"
+#include "components.h"
+
+// arc flags use the finest level with at most this many cells
+static const int MAX_FLAG_CELLS = 128;
+
+//
+// loadCampusMap
+//
+bool loadCampusMap(const std::string &filename, CampusMap &campus,
+                   const LoadOptions &options)
+{
+    tinyxml2::XMLDocument xmldoc;
+
+    // Load XML-based map file
+    if (!LoadOpenStreetMap(filename, xmldoc))
+        return false;
+
+    // Read the nodes, which are the various known positions on the map:
+    size_t nodeCount = ReadMapNodes(xmldoc, campus.Nodes);
+
+    // Read the footways, which are the walking paths:
+    size_t footwayCount = ReadFootways(xmldoc, campus.Footways);
+
+    // Read the university buildings:
+    size_t buildingCount = ReadUniversityBuildings(xmldoc, campus.Nodes, campus.Buildings);
+
+    // Stats
+    assert(nodeCount == campus.Nodes.size());
+    assert(footwayCount == campus.Footways.size());
+    assert(buildingCount == campus.Buildings.size());
+    (void)nodeCount;
+    (void)footwayCount;
+    (void)buildingCount;
+
+    addBuildings(campus.Buildings, campus.BuildingsAbbreviation, campus.BuildingsFullname);
+    buildCompactGraph(campus.Footways, campus.Nodes, campus.Graph);
+    reorderGraph(campus.Graph, options.Order);
+    labelComponents(campus.Graph);
+    campus.SnapToGiant = options.SnapToGiant;
+
+    if (!options.CellSizes.empty())
+    {
+        std::string file = options.PartitionFile != "" ? options.PartitionFile : filename + ".cells";
+        bool cached = readPartition(file, campus.Graph, campus.Cells) &&
+                      campus.Cells.MaxCellSize == options.CellSizes;
+        if (!cached)
+        {
+            buildPartition(campus.Graph, options.CellSizes, campus.Cells);
+            writePartition(file, campus.Graph, campus.Cells);
+        }
+    }
+    if (options.UseCrp && !campus.Cells.empty())
+    {
+        buildCrpOverlay(campus.Graph, campus.Cells, campus.Overlay);
+        customizeCrp(campus.Graph, campus.Cells, campus.Overlay, campus.Graph.Weights,
+                     campus.OverlayMetric);
+    }
+    if (options.UseArcFlags && !campus.Cells.empty())
+    {
+        int level = arcFlagLevel(campus.Cells, MAX_FLAG_CELLS);
+        if (level < 0)
+            level = campus.Cells.NumLevels() - 1;
+        buildArcFlags(campus.Graph, campus.Cells, level, campus.Flags);
+    }
+
+    std::shared_ptr<Closures> closures = std::make_shared<Closures>();
+    applyClosures(campus.Graph, *closures);
+    campus.Closed = closures;
+
+    if (options.NumLandmarks > 0)
+    {
+        int count = landmarkBudget(campus.Graph, options.NumLandmarks, options.LandmarkBudgetBytes);
+        bool cached = options.LandmarkFile != "" &&
+                      readLandmarks(options.LandmarkFile, campus.Graph, campus.Alt) &&
+                      campus.Alt.K() == count;
+        if (!cached)
+        {
+            buildLandmarks(campus.Graph, count, options.LandmarkSelect, campus.Alt);
+            if (options.LandmarkFile != "")
+                writeLandmarks(options.LandmarkFile, campus.Graph, campus.Alt);
+        }
+    }
+    if (options.QuantizeUnitsPerMile > 0)
+        quantizeWeights(campus.Graph, options.QuantizeUnitsPerMile);
+
+    if (options.UseHierarchy)
+        buildContractionHierarchy(campus.Graph, campus.Hierarchy);
+
+    if (options.UseCch)
+    {
+        buildCchTopology(campus.Graph, campus.Cch);
+        for (const std::string &name : weightingNames())
+        {
+            std::vector<WeightRule> rules;
+            std::vector<double> weights;
+            weightingRules(name, rules);
+            footwayWeights(campus.Graph, campus.Footways, rules, weights);
+
+            campus.Metrics.push_back(CchMetric());
+            customizeCch(campus.Cch, weights, campus.Metrics.back());
+            campus.Metrics.back().Name = name;
+        }
+    }
+
+    if (options.UseHubLabels)
+        buildHubLabels(campus.Graph, campus.Labels, options.HubLabelPaths);
+
+    if (options.Simplify)
+    {
+        simplifyGraph(campus.Graph, campus.Simplified);
+        if (options.QuantizeUnitsPerMile > 0)
+            quantizeWeights(campus.Simplified.Core, options.QuantizeUnitsPerMile);
+    }
+
+    // Snap every building once, so lookups never scan the graph
+    for (BuildingInfo &building : campus.Buildings)
+        campus.BuildingVertex[building.Coords.ID] =
+            snapLocation(campus, building.Coords.Lat, building.Coords.Lon);
+
+    return true;
+}
+
+void addBuildings(
+    std::vector<BuildingInfo> &Buildings,
+    std::map<std::string, BuildingInfo> &buildingsAbbreviation,
+    std::map<std::string, BuildingInfo> &buildingsFullname)
+{
+    for (BuildingInfo building : Buildings)
+    {
+        buildingsAbbreviation.emplace(building.Abbrev, building);
+        buildingsFullname.emplace(building.Fullname.substr(0, building.Fullname.find('(') - 1), building);
+    }
+}
+
+std::vector<std::string> splitStr(std::string x, char c)
+{
+    std::stringstream ss(x);
+    std::string item;
+    std::vector<std::string> splittedStrings;
+
+    while (std::getline(ss, item, c))
+        splittedStrings.push_back(item);
+    return splittedStrings;
+}
+
+bool setBuildingInfo(
+    const std::map<std::string, BuildingInfo> &buildingsAbbreviation,
+    const std::map<std::string, BuildingInfo> &buildingsFullname,
+    BuildingInfo &buildingInfo,
+    std::string query)
+{
+    auto iterAbbrev = buildingsAbbreviation.find(query);
+    if (iterAbbrev == buildingsAbbreviation.end())
+    { // Abbreviation was not found, so we'll search for Fullname
+        auto iterFname = buildingsFullname.find(query);
+        if (iterFname != buildingsFullname.end())
+        {
+            buildingInfo = iterFname->second;
+            return true;
+        }
+        else
+        {
+            // We will search for a partial match
+            std::vector<std::string> words = splitStr(query, ' ');
+
+            for (auto &iter : buildingsFullname)
+            {
+                for (std::string w : words)
+                {
+                    std::vector<std::string> splitName = splitStr(iter.second.Fullname, ' ');
+                    for (std::string sn : splitName)
+                    {
+                        if (w == sn)
+                        {
+                            buildingInfo = iter.second;
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+    }
+    buildingInfo = iterAbbrev->second;
+    return true;
+}
+
+int resolveLocation(const CampusMap &campus, const std::string &query)
+{
+    //
+    // all digits (with an optional sign)?  Then it's a node id:
+    //
+    size_t first = (query.size() > 1 && query[0] == '-') ? 1 : 0;
+    bool numeric = first < query.size() &&
+                   query.find_first_not_of("0123456789", first) == std::string::npos;
+
+    if (numeric)
+    {
+        long long id = std::strtoll(query.c_str(), nullptr, 10);
+        int v = campus.Graph.vertexOf(id);
+        if (v >= 0)
+            return v;
+
+        auto node = campus.Nodes.find(id);
+        if (node != campus.Nodes.end())
+            return snapLocation(campus, node->second.Lat, node->second.Lon);
+    }
+
+    BuildingInfo building;
+    if (!setBuildingInfo(campus.BuildingsAbbreviation, campus.BuildingsFullname, building, query))
+        return -1;
+
+    auto snapped = campus.BuildingVertex.find(building.Coords.ID);
+    if (snapped == campus.BuildingVertex.end())
+        return -1;
+    return snapped->second;
+}
+
+int snapLocation(const CampusMap &campus, double lat, double lon)
+{
+    return nearestVertex(campus.Graph, lat, lon, campus.SnapToGiant);
+}
+
+//
+// currentClosures
+//
+ClosuresPtr currentClosures(const CampusMap &campus)
+{
+    return std::atomic_load(&campus.Closed);
+}
+
+//
+// repairMetrics
+//
+void repairMetrics(const CampusMap &campus, Closures &C)
+{
+    C.Repaired.reset();
+    if (C.empty() || (campus.Metrics.empty() && campus.Overlay.empty()))
+        return;
+
+    // every edge the closures block, both ways, and the vertices at them
+    const CompactGraph &G = campus.Graph;
+    std::vector<int> cut, vertices;
+    for (int u = 0; u < G.NumVertices(); ++u)
+    {
+        bool touched = false;
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            if (C.edgeClosed(e) || C.vertexClosed(u) || C.vertexClosed(G.Targets[e]))
+            {
+                cut.push_back(e);
+                touched = true;
+            }
+        if (touched)
+            vertices.push_back(u);
+    }
+
+    std::shared_ptr<ClosedMetrics> repaired = std::make_shared<ClosedMetrics>();
+    for (const CchMetric &open : campus.Metrics)
+    {
+        repaired->Metrics.push_back(open);
+        CchMetric &M = repaired->Metrics.back();
+        for (int e : cut)
+            M.EdgeWeights[e] = INF_DIST;
+        recustomizeCch(campus.Cch, vertices, M);
+    }
+    if (!campus.Overlay.empty())
+    {
+        CrpMetric &M = repaired->OverlayMetric;
+        M = campus.OverlayMetric;
+        for (int e : cut)
+            M.EdgeWeights[e] = INF_DIST;
+        recustomizeCrp(G, campus.Cells, campus.Overlay, vertices, M);
+    }
+    C.Repaired = repaired;
+}
+
+//
+// publishClosures
+//
+void publishClosures(const CampusMap &campus, ClosuresPtr closures)
+{
+    std::atomic_store(&campus.Closed, closures);
+}
@@ -0,0 +1,174 @@
+/*campus.h*/
+
+//
+// Everything the router needs about one loaded map: the raw OSM data,
+// the building lookup tables, and the compact footway graph, plus the
+// helpers that turn a user's "start" or "destination" text into a
+// graph vertex.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include "osm.h"
+#include "compactgraph.h"
+#include "simplify.h"
+#include "reorder.h"
+#include "alt.h"
+#include "hublabels.h"
+#include "ch.h"
+#include "cch.h"
+#include "partition.h"
+#include "crp.h"
+#include "arcflags.h"
+#include "metrics.h"
+#include "closures.h"
+
+//
+// ClosedMetrics
+//
+// The customizations of a CampusMap redone for one set of closures
+// (see closures.h and repairMetrics).
+//
+struct ClosedMetrics
+{
+    std::vector<CchMetric> Metrics; // as CampusMap::Metrics
+    CrpMetric OverlayMetric;        // as CampusMap::OverlayMetric
+};
+
+struct CampusMap
+{
+    std::map<long long, Coordinates> Nodes; // maps a Node ID to it's coordinates (lat, lon)
+    std::vector<FootwayInfo> Footways;      // info about each footway, in no particular order
+    std::vector<BuildingInfo> Buildings;    // info about each building, in no particular order
+    std::map<std::string, BuildingInfo> BuildingsAbbreviation;
+    std::map<std::string, BuildingInfo> BuildingsFullname;
+    std::unordered_map<long long, int> BuildingVertex; // building ID -> nearest graph vertex
+    CompactGraph Graph;
+    SimplifiedGraph Simplified; // empty unless LoadOptions::Simplify
+    Landmarks Alt;              // empty unless LoadOptions::NumLandmarks > 0
+    HubLabels Labels;           // empty unless LoadOptions::UseHubLabels
+    ContractionHierarchy Hierarchy; // empty unless LoadOptions::UseHierarchy
+    CchTopology Cch;                // empty unless LoadOptions::UseCch
+    std::vector<CchMetric> Metrics; // one per weightingNames(), customized on Cch
+    Partition Cells;                // empty unless LoadOptions::CellSizes
+    CrpOverlay Overlay;             // empty unless LoadOptions::UseCrp
+    CrpMetric OverlayMetric;        // the overlay customized for Graph.Weights
+    ArcFlags Flags;                 // empty unless LoadOptions::UseArcFlags
+    bool SnapToGiant;           // see LoadOptions
+    mutable ClosuresPtr Closed; // replaced at runtime: use currentClosures / publishClosures
+
+    CampusMap()
+    {
+        SnapToGiant = false;
+    }
+};
+
+//
+// LoadOptions
+//
+// Optional steps applied to the compact graph after it is built.
+//
+struct LoadOptions
+{
+    double QuantizeUnitsPerMile; // > 0: also build integer weights
+    bool Simplify;               // also contract degree-2 chains
+    VertexOrder Order;           // numbering of the dense vertices
+    bool SnapToGiant;            // snap only onto the largest component
+    int NumLandmarks;            // > 0: route with ALT, this many landmarks
+    LandmarkStrategy LandmarkSelect;
+    size_t LandmarkBudgetBytes;  // fewer landmarks if the table won't fit
+    std::string LandmarkFile;    // if set, reuse (or save) the table here
+    bool UseHubLabels;           // answer queries from hub labels
+    bool HubLabelPaths;          // ... which can also recover paths
+    bool UseHierarchy;           // build a contraction hierarchy (for PHAST)
+    bool UseCch;                 // route with a CCH, under every weighting
+    std::vector<int> CellSizes;  // non-empty: partition into cells, finest first
+    std::string PartitionFile;   // reuse (or save) the cells here; "" means
+                                 // next to the map, as <mapfile>.cells
+    bool UseCrp;                 // route on a multi-level overlay of the cells
+    bool UseArcFlags;            // route by arc flags toward the cells
+
+    LoadOptions()
+    {
+        QuantizeUnitsPerMile = 0.0;
+        Simplify = false;
+        Order = ORDER_OSM;
+        SnapToGiant = false;
+        NumLandmarks = 0;
+        LandmarkSelect = LANDMARKS_AVOID;
+        LandmarkBudgetBytes = (size_t)256 << 20;
+        UseHubLabels = false;
+        HubLabelPaths = true;
+        UseHierarchy = false;
+        UseCch = false;
+        UseCrp = false;
+        UseArcFlags = false;
+    }
+};
+
+//
+// loadCampusMap
+//
+// Parses filename and builds the lookup tables and compact graph.
+// Returns false if the file is not a valid open street map.
+//
+bool loadCampusMap(const std::string &filename, CampusMap &campus,
+                   const LoadOptions &options = LoadOptions());
+
+void addBuildings(
+    std::vector<BuildingInfo> &Buildings,
+    std::map<std::string, BuildingInfo> &buildingsAbbreviation,
+    std::map<std::string, BuildingInfo> &buildingsFullname);
+
+/**
+ * Given a string and a char
+ * splitStr returns an array of with strings seperated by c
+ * Ex. "This is a text" -> ["This", "is", "a", "text"]
+ */
+std::vector<std::string> splitStr(std::string x, char c);
+
+/**
+ * Looks query up as an abbreviation, then as a full name, then as a
+ * partial (word) match of a full name.  Returns false if no building
+ * matches.
+ */
+bool setBuildingInfo(
+    const std::map<std::string, BuildingInfo> &buildingsAbbreviation,
+    const std::map<std::string, BuildingInfo> &buildingsFullname,
+    BuildingInfo &buildingInfo,
+    std::string query);
+
+/**
+ * Resolves a location to a graph vertex.  query is a building
+ * (abbreviation, name or partial name) or a numeric OSM node id;
+ * a node that is not on a footway is snapped to the nearest one.
+ * Returns -1 if nothing matches.
+ */
+int resolveLocation(const CampusMap &campus, const std::string &query);
+
+/**
+ * Nearest footway vertex to (lat, lon), honoring SnapToGiant; -1 if
+ * the map has no footways.
+ */
+int snapLocation(const CampusMap &campus, double lat, double lon);
+
+/**
+ * The closures in effect on campus right now (see closures.h), and
+ * replacing them; both are atomic, so queries may run meanwhile
+ */
+ClosuresPtr currentClosures(const CampusMap &campus);
+void publishClosures(const CampusMap &campus, ClosuresPtr closures);
+
+/**
+ * Sets C.Repaired for campus: its CCH weightings and CRP overlay with
+ * every edge that C closes (or that touches a node C closes) cut, by
+ * customizing again only the parts those edges feed.  Left empty if
+ * C closes nothing or campus has neither structure.  Call it on a new
+ * Closures before publishing it.
+ */
+void repairMetrics(const CampusMap &campus, Closures &C);
@@ -0,0 +1,492 @@
+/*cch.cpp*/
+
+//
+// Customizable contraction hierarchy (CCH).
+//
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "cch.h"
+#include "threadpool.h"
+
+namespace
+{
+// cells this small are not cut any further
+const size_t DISSECTION_LEAF = 16;
+
+// levels with fewer vertices than this are customized on one thread
+const size_t PARALLEL_LEVEL = 512;
+
+//
+// Dissection
+//
+// Nested dissection by coordinate bisection.  Each cell is split at
+// the median of its wider extent; the smaller of the two sides of the
+// cut becomes the separator, ranked above everything in the cell.
+//
+struct Dissection
+{
+    const CompactGraph &G;
+    std::vector<int> side; // stamp of the half a vertex is in
+    int stamp;
+    std::vector<int> order; // rank -> vertex, built lowest first
+
+    Dissection(const CompactGraph &graph)
+        : G(graph)
+    {
+        this->side.assign(graph.NumVertices(), 0);
+        this->stamp = 0;
+    }
+
+    //
+    // boundary
+    //
+    // The vertices of half with a neighbor in the other half (stamp
+    // theirs).
+    //
+    std::vector<int> boundary(const std::vector<int> &half, int theirs)
+    {
+        std::vector<int> cut;
+        for (int v : half)
+        {
+            for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            {
+                if (this->side[G.Targets[e]] == theirs)
+                {
+                    cut.push_back(v);
+                    break;
+                }
+            }
+        }
+        return cut;
+    }
+
+    void dissect(std::vector<int> &cell)
+    {
+        if (cell.size() <= DISSECTION_LEAF)
+        {
+            this->order.insert(this->order.end(), cell.begin(), cell.end());
+            return;
+        }
+
+        //
+        // cut across the wider extent, at the median:
+        //
+        double minLat = G.Lat[cell[0]], maxLat = minLat;
+        double minLon = G.Lon[cell[0]], maxLon = minLon;
+        for (int v : cell)
+        {
+            minLat = std::min(minLat, G.Lat[v]);
+            maxLat = std::max(maxLat, G.Lat[v]);
+            minLon = std::min(minLon, G.Lon[v]);
+            maxLon = std::max(maxLon, G.Lon[v]);
+        }
+        double lonScale = std::cos((minLat + maxLat) / 2 * 3.14159265 / 180.0);
+        bool byLat = (maxLat - minLat) >= (maxLon - minLon) * lonScale;
+
+        size_t middle = cell.size() / 2;
+        std::nth_element(cell.begin(), cell.begin() + middle, cell.end(), [&](int a, int b) {
+            return byLat ? G.Lat[a] < G.Lat[b] : G.Lon[a] < G.Lon[b];
+        });
+
+        std::vector<int> a(cell.begin(), cell.begin() + middle);
+        std::vector<int> b(cell.begin() + middle, cell.end());
+        std::vector<int>().swap(cell); // the halves are all that is needed now
+
+        int stampA = ++this->stamp, stampB = ++this->stamp;
+        for (int v : a)
+            this->side[v] = stampA;
+        for (int v : b)
+            this->side[v] = stampB;
+
+        std::vector<int> cutA = this->boundary(a, stampB);
+        std::vector<int> cutB = this->boundary(b, stampA);
+        bool fromA = cutA.size() <= cutB.size();
+        std::vector<int> &separator = fromA ? cutA : cutB;
+        std::vector<int> &half = fromA ? a : b;
+
+        int stampS = ++this->stamp;
+        for (int v : separator)
+            this->side[v] = stampS;
+        half.erase(std::remove_if(half.begin(), half.end(),
+                                  [&](int v) { return this->side[v] == stampS; }),
+                   half.end());
+
+        this->dissect(a);
+        this->dissect(b);
+        this->order.insert(this->order.end(), separator.begin(), separator.end());
+    }
+};
+}
+
+//
+// buildCchTopology
+//
+void buildCchTopology(const CompactGraph &G, CchTopology &T)
+{
+    auto start = std::chrono::steady_clock::now();
+    T = CchTopology();
+    int n = G.NumVertices();
+
+    std::vector<int> cell(n);
+    for (int v = 0; v < n; ++v)
+        cell[v] = v;
+    Dissection D(G);
+    D.dissect(cell);
+    T.Order.swap(D.order);
+    T.Rank.assign(n, -1);
+    for (int r = 0; r < n; ++r)
+        T.Rank[T.Order[r]] = r;
+
+    //
+    // Contract in rank order without weights: the upper neighbors of r
+    // become a clique, which it is enough to hand to r's lowest upper
+    // neighbor (its parent), since that one is contracted next of them.
+    //
+    std::vector<std::vector<int>> up(n);
+    for (int v = 0; v < n; ++v)
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            if (T.Rank[G.Targets[e]] > T.Rank[v])
+                up[T.Rank[v]].push_back(T.Rank[G.Targets[e]]);
+
+    T.Parent.assign(n, -1);
+    T.UpOffsets.assign(n + 1, 0);
+    for (int r = 0; r < n; ++r)
+    {
+        std::vector<int> &arcs = up[r];
+        std::sort(arcs.begin(), arcs.end());
+        arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+        if (!arcs.empty())
+        {
+            int parent = arcs[0];
+            T.Parent[r] = parent;
+            up[parent].insert(up[parent].end(), arcs.begin() + 1, arcs.end());
+        }
+
+        T.UpTargets.insert(T.UpTargets.end(), arcs.begin(), arcs.end());
+        T.UpOffsets[r + 1] = (int)T.UpTargets.size();
+        std::vector<int>().swap(arcs);
+    }
+
+    //
+    // the edge behind each arc, if any:
+    //
+    std::vector<int> edgeTo(n, -1); // rank -> edge from the current vertex
+    T.UpEdge.assign(T.UpTargets.size(), -1);
+    for (int r = 0; r < n; ++r)
+    {
+        int v = T.Order[r];
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            edgeTo[T.Rank[G.Targets[e]]] = e;
+        for (int a = T.UpOffsets[r]; a < T.UpOffsets[r + 1]; ++a)
+        {
+            T.UpEdge[a] = edgeTo[T.UpTargets[a]];
+            if (T.UpEdge[a] < 0)
+                T.NumFillIn++;
+        }
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            edgeTo[T.Rank[G.Targets[e]]] = -1;
+    }
+
+    //
+    // arcs by head, for looking down:
+    //
+    T.DownOffsets.assign(n + 1, 0);
+    for (int head : T.UpTargets)
+        T.DownOffsets[head + 1]++;
+    for (int r = 0; r < n; ++r)
+        T.DownOffsets[r + 1] += T.DownOffsets[r];
+    T.DownTails.resize(T.UpTargets.size());
+    T.DownArcs.resize(T.UpTargets.size());
+    std::vector<int> next(T.DownOffsets.begin(), T.DownOffsets.end() - 1);
+    for (int r = 0; r < n; ++r)
+    {
+        for (int a = T.UpOffsets[r]; a < T.UpOffsets[r + 1]; ++a)
+        {
+            int slot = next[T.UpTargets[a]]++;
+            T.DownTails[slot] = r;
+            T.DownArcs[slot] = a;
+        }
+    }
+
+    //
+    // levels: one above the highest lower neighbor
+    //
+    std::vector<int> level(n, 0);
+    int numLevels = n > 0 ? 1 : 0;
+    for (int r = 0; r < n; ++r)
+    {
+        for (int a = T.UpOffsets[r]; a < T.UpOffsets[r + 1]; ++a)
+        {
+            int &l = level[T.UpTargets[a]];
+            l = std::max(l, level[r] + 1);
+            numLevels = std::max(numLevels, l + 1);
+        }
+    }
+    T.LevelOffsets.assign(numLevels + 1, 0);
+    for (int r = 0; r < n; ++r)
+        T.LevelOffsets[level[r] + 1]++;
+    for (int l = 0; l < numLevels; ++l)
+        T.LevelOffsets[l + 1] += T.LevelOffsets[l];
+    T.LevelRanks.resize(n);
+    next.assign(T.LevelOffsets.begin(), T.LevelOffsets.end() - 1);
+    for (int r = 0; r < n; ++r)
+        T.LevelRanks[next[level[r]]++] = r;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    T.BuildSeconds = elapsed.count();
+}
+
+//
+// customizeVertex
+//
+// Sets the weights of r's upward arcs: the edge each stands for, then
+// every lower triangle r-u-x.  Reads only arcs of lower levels.
+//
+static void customizeVertex(const CchTopology &T, const std::vector<double> &edgeWeights,
+                            std::vector<double> &weights, int r)
+{
+    int first = T.UpOffsets[r], last = T.UpOffsets[r + 1];
+    for (int a = first; a < last; ++a)
+        weights[a] = T.UpEdge[a] >= 0 ? edgeWeights[T.UpEdge[a]] : INF_DIST;
+
+    for (int d = T.DownOffsets[r]; d < T.DownOffsets[r + 1]; ++d)
+    {
+        int u = T.DownTails[d];
+        int down = T.DownArcs[d]; // u -> r
+        if (weights[down] == INF_DIST)
+            continue;
+
+        // u's arcs above r are a subset of r's arcs; walk both by head
+        int a = first;
+        for (int b = down + 1; b < T.UpOffsets[u + 1]; ++b)
+        {
+            int x = T.UpTargets[b];
+            while (T.UpTargets[a] < x)
+                ++a;
+            if (weights[b] != INF_DIST)
+                weights[a] = std::min(weights[a], weights[down] + weights[b]);
+        }
+    }
+}
+
+//
+// customizeCch
+//
+void customizeCch(const CchTopology &T, const std::vector<double> &edgeWeights,
+                  CchMetric &M, int numThreads)
+{
+    auto start = std::chrono::steady_clock::now();
+    M.EdgeWeights = edgeWeights;
+    M.UpWeights.assign(T.NumArcs(), INF_DIST);
+
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    std::unique_ptr<WorkStealingPool> pool;
+    if (numThreads > 1)
+        pool.reset(new WorkStealingPool(numThreads));
+
+    for (size_t l = 0; l + 1 < T.LevelOffsets.size(); ++l)
+    {
+        const int *ranks = T.LevelRanks.data() + T.LevelOffsets[l];
+        size_t count = T.LevelOffsets[l + 1] - T.LevelOffsets[l];
+
+        if (!pool || count < PARALLEL_LEVEL)
+        {
+            for (size_t i = 0; i < count; ++i)
+                customizeVertex(T, M.EdgeWeights, M.UpWeights, ranks[i]);
+            continue;
+        }
+
+        pool->parallelFor(count, PARALLEL_LEVEL / 4, [&](size_t begin, size_t end, int worker) {
+            for (size_t i = begin; i < end; ++i)
+                customizeVertex(T, M.EdgeWeights, M.UpWeights, ranks[i]);
+        });
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    M.CustomizeSeconds = elapsed.count();
+}
+
+//
+// recustomizeCch
+//
+void recustomizeCch(const CchTopology &T, const std::vector<int> &vertices, CchMetric &M)
+{
+    // a vertex reads only the arcs below it, all from its descendants
+    std::vector<char> dirty(T.NumVertices(), 0);
+    std::vector<int> ranks;
+    for (int v : vertices)
+        for (int r = T.Rank[v]; r != -1 && !dirty[r]; r = T.Parent[r])
+        {
+            dirty[r] = 1;
+            ranks.push_back(r);
+        }
+
+    std::sort(ranks.begin(), ranks.end());
+    for (int r : ranks)
+        customizeVertex(T, M.EdgeWeights, M.UpWeights, r);
+}
+
+//
+// findArc
+//
+// The arc from rank tail to rank head, -1 if there is none.
+//
+static int findArc(const CchTopology &T, int tail, int head)
+{
+    auto first = T.UpTargets.begin() + T.UpOffsets[tail];
+    auto last = T.UpTargets.begin() + T.UpOffsets[tail + 1];
+    auto it = std::lower_bound(first, last, head);
+    return (it != last && *it == head) ? (int)(it - T.UpTargets.begin()) : -1;
+}
+
+//
+// unpackArc
+//
+// Appends the ranks along arc a after its starting end: tail to head
+// if upward, else head to tail.  An arc whose weight its own edge does
+// not explain is a lower triangle tail-u-head with that weight.
+//
+static void unpackArc(const CchTopology &T, const CchMetric &M, int tail, int a, bool upward,
+                      std::vector<int> &ranks)
+{
+    int head = T.UpTargets[a];
+    double w = M.UpWeights[a];
+
+    if (T.UpEdge[a] < 0 || M.EdgeWeights[T.UpEdge[a]] != w)
+    {
+        for (int d = T.DownOffsets[tail]; d < T.DownOffsets[tail + 1]; ++d)
+        {
+            int u = T.DownTails[d];
+            int down = T.DownArcs[d]; // u -> tail
+            int across = findArc(T, u, head);
+            if (across < 0 || M.UpWeights[down] + M.UpWeights[across] != w)
+                continue;
+
+            if (upward)
+            {
+                unpackArc(T, M, u, down, false, ranks);
+                unpackArc(T, M, u, across, true, ranks);
+            }
+            else
+            {
+                unpackArc(T, M, u, across, false, ranks);
+                unpackArc(T, M, u, down, true, ranks);
+            }
+            return;
+        }
+    }
+    ranks.push_back(upward ? head : tail);
+}
+
+//
+// upwardSearch
+//
+// Relaxes the upward arcs of every ancestor of rank r in turn, leaving
+// distances and the arc each was reached by in W (by rank); returns
+// the ancestors, r first.
+//
+static std::vector<int> upwardSearch(const CchTopology &T, const CchMetric &M, int r,
+                                     SearchWorkspace &W)
+{
+    std::vector<int> chain;
+    W.touch(r);
+    W.Dist[r] = 0.0;
+    for (int x = r; x != -1; x = T.Parent[x])
+    {
+        chain.push_back(x);
+        W.NumSettled++;
+        if (W.Dist[x] == INF_DIST)
+            continue;
+        for (int a = T.UpOffsets[x]; a < T.UpOffsets[x + 1]; ++a)
+        {
+            int y = T.UpTargets[a];
+            double alt = W.Dist[x] + M.UpWeights[a];
+            if (M.UpWeights[a] != INF_DIST && alt < W.Dist[y])
+            {
+                W.touch(y);
+                W.Dist[y] = alt;
+                W.Pred[y] = a;
+            }
+        }
+    }
+    return chain;
+}
+
+//
+// cchRoute
+//
+bool cchRoute(const CchTopology &T, const CchMetric &M, int source, int target,
+              SearchWorkspace &W, std::vector<int> &path, double &miles)
+{
+    path.clear();
+    int s = T.Rank[source], t = T.Rank[target];
+
+    // from the source; keep its side, since W is needed for the other
+    W.reset();
+    std::vector<int> chain = upwardSearch(T, M, s, W);
+    std::vector<double> fromSource(chain.size());
+    std::vector<int> arcFromSource(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        fromSource[i] = W.Dist[chain[i]];
+        arcFromSource[i] = W.Pred[chain[i]];
+    }
+    long long settled = W.NumSettled;
+
+    W.reset();
+    upwardSearch(T, M, t, W);
+    W.NumSettled += settled;
+
+    // both chains end in the same root if there is a route at all
+    double best = INF_DIST;
+    size_t meet = 0;
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        int x = chain[i];
+        if (fromSource[i] != INF_DIST && W.Dist[x] != INF_DIST && fromSource[i] + W.Dist[x] < best)
+        {
+            best = fromSource[i] + W.Dist[x];
+            meet = i;
+        }
+    }
+    if (best == INF_DIST)
+        return false;
+    miles = best;
+
+    //
+    // down the source side to the meeting vertex, then back down the
+    // target side, unpacking every arc on the way:
+    //
+    std::vector<int> arcs; // source side, from the meeting vertex down
+    for (size_t i = meet; chain[i] != s;)
+    {
+        int a = arcFromSource[i];
+        arcs.push_back(a);
+        int tail = (int)(std::upper_bound(T.UpOffsets.begin(), T.UpOffsets.end(), a) - T.UpOffsets.begin()) - 1;
+        i = std::lower_bound(chain.begin(), chain.end(), tail) - chain.begin();
+    }
+
+    std::vector<int> ranks(1, s);
+    for (size_t i = arcs.size(); i-- > 0;)
+    {
+        int tail = ranks.back();
+        unpackArc(T, M, tail, arcs[i], true, ranks);
+    }
+    for (int x = chain[meet]; x != t;)
+    {
+        int a = W.Pred[x];
+        int tail = (int)(std::upper_bound(T.UpOffsets.begin(), T.UpOffsets.end(), a) - T.UpOffsets.begin()) - 1;
+        unpackArc(T, M, tail, a, false, ranks);
+        x = tail;
+    }
+
+    for (int r : ranks)
+        path.push_back(T.Order[r]);
+    return true;
+}
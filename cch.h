@@ -0,0 +1,139 @@
+/*cch.h*/
+
+//
+// Customizable contraction hierarchy (CCH).
+//
+// A contraction hierarchy (ch.h) picks its order by how much the
+// current weights make each vertex matter, so new weights mean
+// contracting all over again.  A CCH splits the work in two:
+//
+//   - the topology, once per map: a nested-dissection order (cut the
+//     map in half at its median, rank the vertices on the cut above
+//     both halves, recurse into each half), and the arcs contracting
+//     in that order adds for *any* weights: the upper neighbors of
+//     every vertex are joined into a clique;
+//   - customization, once per weighting: every arc starts with the
+//     weight of the edge it stands for (none for a fill-in arc) and is
+//     lowered through every "lower triangle" v-u-w with u below both.
+//     Each vertex pulls the weights of its own upward arcs from the
+//     vertices below it, so all vertices of one level -- no arc runs
+//     between them -- are customized in parallel.
+//
+// The upper neighbors of a vertex are all its ancestors in the
+// elimination tree (parent = lowest upper neighbor), so a query needs
+// no queue: it relaxes the upward arcs of every ancestor of the source
+// in order, does the same from the target, and takes the best common
+// ancestor.
+//
+// The hierarchy is stored in rank space, like ch.h -- vertex r below
+// is the vertex of rank r:
+//
+//   UpOffsets[r] .. UpOffsets[r+1]-1   the upward arcs of r, by head
+//   UpTargets[a]                       head of arc a (a higher rank)
+//   UpEdge[a]                          the CompactGraph edge arc a
+//                                      stands for, -1 for fill-in
+//   DownOffsets[r] .. DownOffsets[r+1]-1
+//                                      index DownTails / DownArcs: the
+//                                      arcs into r from below
+//
+// A CchMetric is one weighting customized on a topology.  Any number
+// of them share one topology.  Weights must be symmetric (footways are
+// two-way), as the metrics.h weightings are.
+//
+// Dibbelt, Strasser and Wagner, "Customizable Contraction Hierarchies"
+// (ACM JEA 2016).
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+#include "search.h"
+
+struct CchTopology
+{
+    std::vector<int> Rank;  // vertex -> rank
+    std::vector<int> Order; // rank -> vertex
+    std::vector<int> UpOffsets;
+    std::vector<int> UpTargets;
+    std::vector<int> UpEdge;
+    std::vector<int> DownOffsets;
+    std::vector<int> DownTails;
+    std::vector<int> DownArcs;
+    std::vector<int> Parent;       // rank -> elimination-tree parent, -1 for a root
+    std::vector<int> LevelOffsets; // LevelRanks[LevelOffsets[l] .. LevelOffsets[l+1]-1]
+    std::vector<int> LevelRanks;   // are the ranks of level l
+    int NumFillIn;                 // arcs with no edge of their own
+    double BuildSeconds;
+
+    CchTopology()
+    {
+        NumFillIn = 0;
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->Order.empty();
+    }
+
+    int NumVertices() const
+    {
+        return (int)this->Order.size();
+    }
+
+    int NumArcs() const
+    {
+        return (int)this->UpTargets.size();
+    }
+};
+
+struct CchMetric
+{
+    std::string Name;
+    std::vector<double> EdgeWeights; // the weighting, per CompactGraph edge
+    std::vector<double> UpWeights;   // customized, per arc
+    double CustomizeSeconds;
+
+    CchMetric()
+    {
+        CustomizeSeconds = 0.0;
+    }
+};
+
+//
+// buildCchTopology
+//
+// Orders G by nested dissection and builds the metric-independent
+// hierarchy.
+//
+void buildCchTopology(const CompactGraph &G, CchTopology &T);
+
+//
+// customizeCch
+//
+// Customizes T for edgeWeights (one per edge of the graph T was built
+// from) into M, on numThreads threads (<= 0: one per core).
+//
+void customizeCch(const CchTopology &T, const std::vector<double> &edgeWeights,
+                  CchMetric &M, int numThreads = 0);
+
+//
+// recustomizeCch
+//
+// Brings M up to date after M.EdgeWeights changed at the edges around
+// the given vertices: only the upward arcs of those vertices and of
+// their ancestors in the elimination tree are customized again.
+//
+void recustomizeCch(const CchTopology &T, const std::vector<int> &vertices, CchMetric &M);
+
+//
+// cchRoute
+//
+// Shortest route from source to target (dense vertices) under M, using
+// W for scratch.  Returns false if there is none.
+//
+bool cchRoute(const CchTopology &T, const CchMetric &M, int source, int target,
+              SearchWorkspace &W, std::vector<int> &path, double &miles);
@@ -0,0 +1,279 @@
+/*ch.cpp*/
+
+//
+// Contraction hierarchy over the footway graph.
+//
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+
+#include "ch.h"
+#include "search.h"
+#include "pqueue.h"
+
+namespace
+{
+struct ChEdge
+{
+    int To;
+    double Weight;
+    int Middle; // vertex a shortcut skips, -1 for an original edge
+};
+
+//
+// The graph that is left while contracting: adjacency lists of the
+// vertices not contracted yet, plus what the witness searches need.
+//
+class Contractor
+{
+public:
+    std::vector<std::vector<ChEdge>> Adj;
+    std::vector<char> Contracted;
+    std::vector<int> DeletedNeighbors;
+
+private:
+    // witness search state, reset sparsely
+    std::vector<double> dist;
+    std::vector<int> touched;
+    std::vector<char> isTarget;
+    LazyBinaryHeap queue;
+
+    //
+    // witnessSearch
+    //
+    // Distances from source in the remaining graph without via, up to
+    // limit (and settleLimit settled vertices), stopping early once
+    // the numTargets vertices flagged in isTarget are settled; vertices
+    // it did not reach keep INF_DIST.
+    //
+    void witnessSearch(int source, int via, double limit, int settleLimit, int numTargets)
+    {
+        for (int v : this->touched)
+            this->dist[v] = INF_DIST;
+        this->touched.clear();
+
+        LazyBinaryHeap &queue = this->queue;
+        queue.clear();
+        this->dist[source] = 0.0;
+        this->touched.push_back(source);
+        queue.update(source, 0.0);
+
+        int settled = 0;
+        while (!queue.empty() && settled < settleLimit)
+        {
+            std::pair<double, int> current = queue.pop();
+            int u = current.second;
+            if (current.first > this->dist[u])
+                continue; // stale
+            if (current.first > limit)
+                break;
+            settled++;
+            if (this->isTarget[u] && --numTargets == 0)
+                break;
+
+            for (const ChEdge &edge : this->Adj[u])
+            {
+                if (edge.To == via)
+                    continue;
+                double alt = current.first + edge.Weight;
+                if (alt < this->dist[edge.To])
+                {
+                    if (this->dist[edge.To] == INF_DIST)
+                        this->touched.push_back(edge.To);
+                    this->dist[edge.To] = alt;
+                    queue.update(edge.To, alt);
+                }
+            }
+        }
+    }
+
+    //
+    // addOrImprove
+    //
+    // Adds edge u -> (to, weight) unless a no longer one exists.
+    //
+    void addOrImprove(int u, int to, double weight, int middle)
+    {
+        for (ChEdge &edge : this->Adj[u])
+        {
+            if (edge.To == to)
+            {
+                if (weight < edge.Weight)
+                {
+                    edge.Weight = weight;
+                    edge.Middle = middle;
+                }
+                return;
+            }
+        }
+        this->Adj[u].push_back(ChEdge{to, weight, middle});
+    }
+
+public:
+    Contractor(const CompactGraph &G)
+    {
+        int n = G.NumVertices();
+        this->Adj.resize(n);
+        this->Contracted.assign(n, 0);
+        this->DeletedNeighbors.assign(n, 0);
+        this->dist.assign(n, INF_DIST);
+        this->isTarget.assign(n, 0);
+
+        for (int u = 0; u < n; ++u)
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (G.Targets[e] != u)
+                    this->Adj[u].push_back(ChEdge{G.Targets[e], G.Weights[e], -1});
+    }
+
+    //
+    // contract
+    //
+    // The shortcuts needed to contract v; unless simulate, also adds
+    // them and removes v from the graph.
+    //
+    int contract(int v, bool simulate)
+    {
+        const std::vector<ChEdge> &edges = this->Adj[v];
+
+        double longest = 0.0;
+        for (const ChEdge &edge : edges)
+            longest = std::max(longest, edge.Weight);
+
+        std::vector<ChEdge> shortcuts; // To = u, Middle = w (both neighbors)
+        for (size_t i = 0; i + 1 < edges.size(); ++i)
+        {
+            int u = edges[i].To;
+
+            // only the neighbors after u still need a witness from u
+            for (size_t j = i + 1; j < edges.size(); ++j)
+                this->isTarget[edges[j].To] = 1;
+
+            // simulations only estimate; a short search will do
+            this->witnessSearch(u, v, edges[i].Weight + longest, simulate ? 20 : 200,
+                                (int)(edges.size() - i - 1));
+
+            for (size_t j = i + 1; j < edges.size(); ++j)
+                this->isTarget[edges[j].To] = 0;
+
+            for (size_t j = i + 1; j < edges.size(); ++j)
+            {
+                double via = edges[i].Weight + edges[j].Weight;
+                if (this->dist[edges[j].To] > via)
+                    shortcuts.push_back(ChEdge{u, via, edges[j].To});
+            }
+        }
+
+        if (simulate)
+            return (int)shortcuts.size();
+
+        for (const ChEdge &s : shortcuts)
+        {
+            this->addOrImprove(s.To, s.Middle, s.Weight, v);
+            this->addOrImprove(s.Middle, s.To, s.Weight, v);
+        }
+
+        for (const ChEdge &edge : this->Adj[v])
+        {
+            std::vector<ChEdge> &back = this->Adj[edge.To];
+            for (size_t k = 0; k < back.size(); ++k)
+            {
+                if (back[k].To == v)
+                {
+                    back[k] = back.back();
+                    back.pop_back();
+                    break;
+                }
+            }
+            this->DeletedNeighbors[edge.To]++;
+        }
+        this->Contracted[v] = 1;
+        return (int)shortcuts.size();
+    }
+
+    int priority(int v)
+    {
+        int shortcuts = this->contract(v, true);
+        return shortcuts - (int)this->Adj[v].size() + this->DeletedNeighbors[v];
+    }
+};
+}
+
+//
+// buildContractionHierarchy
+//
+void buildContractionHierarchy(const CompactGraph &G, ContractionHierarchy &CH)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    CH = ContractionHierarchy();
+    int n = G.NumVertices();
+    Contractor graph(G);
+
+    typedef std::pair<int, int> Entry; // (priority, vertex)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    std::vector<int> current(n);
+    for (int v = 0; v < n; ++v)
+    {
+        current[v] = graph.priority(v);
+        queue.push(Entry(current[v], v));
+    }
+
+    // edges of each vertex to the higher-ranked ones, taken when it
+    // is contracted; Middle is still a vertex, not a rank
+    std::vector<std::vector<ChEdge>> up(n);
+    CH.Rank.assign(n, -1);
+
+    while (!queue.empty())
+    {
+        Entry top = queue.top();
+        queue.pop();
+        int v = top.second;
+        if (graph.Contracted[v] || top.first != current[v])
+            continue;
+
+        //
+        // lazy update: priorities go stale as neighbors are
+        // contracted; if v's has grown past the next one, requeue it.
+        // (Recomputing every neighbor after each contraction instead
+        // costs degree^2 witness searches near the top, for no
+        // measurable gain in query speed.)
+        //
+        current[v] = graph.priority(v);
+        if (!queue.empty() && current[v] > queue.top().first)
+        {
+            queue.push(Entry(current[v], v));
+            continue;
+        }
+
+        CH.Rank[v] = (int)CH.Order.size();
+        CH.Order.push_back(v);
+        up[v] = graph.Adj[v];
+        CH.NumShortcuts += graph.contract(v, false);
+    }
+
+    //
+    // lay the upward graph out in rank space:
+    //
+    CH.UpOffsets.assign(n + 1, 0);
+    for (int r = 0; r < n; ++r)
+    {
+        int v = CH.Order[r];
+        std::sort(up[v].begin(), up[v].end(), [&CH](const ChEdge &a, const ChEdge &b) {
+            return CH.Rank[a.To] < CH.Rank[b.To];
+        });
+        for (const ChEdge &edge : up[v])
+        {
+            CH.UpTargets.push_back(CH.Rank[edge.To]);
+            CH.UpWeights.push_back(edge.Weight);
+            CH.UpMiddle.push_back(edge.Middle < 0 ? -1 : CH.Rank[edge.Middle]);
+        }
+        CH.UpOffsets[r + 1] = (int)CH.UpTargets.size();
+        std::vector<ChEdge>().swap(up[v]);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    CH.BuildSeconds = elapsed.count();
+}
@@ -0,0 +1,73 @@
+/*ch.h*/
+
+//
+// Contraction hierarchy over the footway graph.
+//
+// Vertices are contracted one at a time, least important first.
+// Contracting v removes it from the remaining graph and, for every
+// pair of its remaining neighbors u and w whose only shortest
+// connection ran through v, adds a shortcut u-w with the length of
+// u-v-w.  A bounded "witness" search decides whether a shortcut is
+// needed; when the search gives up early we add the shortcut anyway,
+// which costs space but never correctness.  Importance is the lazily
+// updated edge difference (shortcuts added minus edges removed) plus
+// the number of neighbors already contracted, which spreads the
+// contraction evenly over the map.
+//
+// The rank of a vertex is its position in the contraction order.  For
+// any two vertices there is then a shortest path that first only goes
+// up in rank and then only down, using original edges and shortcuts.
+// Footways are two-way, so one "upward" graph serves both directions:
+// the edges of every vertex to its higher-ranked neighbors at the time
+// it was contracted.
+//
+// The upward graph is stored in rank space -- vertex r below is the
+// vertex of rank r -- so that sweeps over the vertices in rank order
+// (see phast.h) read it front to back:
+//
+//   UpOffsets[r] .. UpOffsets[r+1]-1   index the upward edges of r
+//   UpTargets[e], UpWeights[e]         head (a higher rank) and length
+//   UpMiddle[e]                        rank of the vertex a shortcut
+//                                      skips, -1 for an original edge
+//
+
+#pragma once
+
+#include <vector>
+
+#include "compactgraph.h"
+
+struct ContractionHierarchy
+{
+    std::vector<int> Rank;  // vertex -> rank
+    std::vector<int> Order; // rank -> vertex
+    std::vector<int> UpOffsets;
+    std::vector<int> UpTargets;
+    std::vector<double> UpWeights;
+    std::vector<int> UpMiddle;
+    int NumShortcuts;
+    double BuildSeconds;
+
+    ContractionHierarchy()
+    {
+        NumShortcuts = 0;
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->Order.empty();
+    }
+
+    int NumVertices() const
+    {
+        return (int)this->Order.size();
+    }
+};
+
+//
+// buildContractionHierarchy
+//
+// Contracts G (which must be symmetric) into CH.
+//
+void buildContractionHierarchy(const CompactGraph &G, ContractionHierarchy &CH);
@@ -0,0 +1,137 @@
+/*closures.cpp*/
+
+//
+// Closed footway segments and nodes.
+//
+
+#include <vector>
+#include <algorithm>
+
+#include "closures.h"
+
+static void setBit(std::vector<uint64_t> &bits, int i, bool on)
+{
+    if (on)
+        bits[i >> 6] |= (uint64_t)1 << (i & 63);
+    else
+        bits[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+//
+// setEdgeBits
+//
+// Sets or clears the bits of both directions of edge u - v; returns
+// false if there is no such edge.
+//
+static bool setEdgeBits(const CompactGraph &G, Closures &C, int u, int v, bool on)
+{
+    bool found = false;
+    for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+    {
+        if (G.Targets[e] == v)
+        {
+            setBit(C.EdgeBits, e, on);
+            found = true;
+        }
+    }
+    for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+        if (G.Targets[e] == u)
+            setBit(C.EdgeBits, e, on);
+    return found;
+}
+
+//
+// applyClosures
+//
+void applyClosures(const CompactGraph &G, Closures &C)
+{
+    C.EdgeBits.assign((G.NumEdges() + 63) / 64, 0);
+    C.VertexBits.assign((G.NumVertices() + 63) / 64, 0);
+
+    std::vector<std::pair<long long, long long>> segments;
+    for (const std::pair<long long, long long> &s : C.Segments)
+    {
+        int u = G.vertexOf(s.first);
+        int v = G.vertexOf(s.second);
+        if (u >= 0 && v >= 0 && setEdgeBits(G, C, u, v, true))
+            segments.push_back(s);
+    }
+    C.Segments.swap(segments);
+
+    std::vector<long long> nodes;
+    for (long long id : C.Nodes)
+    {
+        int v = G.vertexOf(id);
+        if (v >= 0)
+        {
+            setBit(C.VertexBits, v, true);
+            nodes.push_back(id);
+        }
+    }
+    C.Nodes.swap(nodes);
+}
+
+//
+// setSegmentClosed
+//
+bool setSegmentClosed(const CompactGraph &G, Closures &C, long long a, long long b, bool closed)
+{
+    int u = G.vertexOf(a);
+    int v = G.vertexOf(b);
+    if (u < 0 || v < 0 || u == v)
+        return false;
+
+    if (C.EdgeBits.empty())
+        applyClosures(G, C);
+    if (!setEdgeBits(G, C, u, v, closed))
+        return false;
+
+    std::pair<long long, long long> segment(std::min(a, b), std::max(a, b));
+    auto it = std::find(C.Segments.begin(), C.Segments.end(), segment);
+    if (closed && it == C.Segments.end())
+        C.Segments.push_back(segment);
+    else if (!closed && it != C.Segments.end())
+        C.Segments.erase(it);
+    return true;
+}
+
+//
+// setNodeClosed
+//
+bool setNodeClosed(const CompactGraph &G, Closures &C, long long id, bool closed)
+{
+    int v = G.vertexOf(id);
+    if (v < 0)
+        return false;
+
+    if (C.VertexBits.empty())
+        applyClosures(G, C);
+    setBit(C.VertexBits, v, closed);
+
+    auto it = std::find(C.Nodes.begin(), C.Nodes.end(), id);
+    if (closed && it == C.Nodes.end())
+        C.Nodes.push_back(id);
+    else if (!closed && it != C.Nodes.end())
+        C.Nodes.erase(it);
+    return true;
+}
+
+//
+// pathOpen
+//
+bool pathOpen(const CompactGraph &G, const Closures &C, const std::vector<int> &path)
+{
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        if (C.vertexClosed(path[i]))
+            return false;
+        if (i + 1 == path.size())
+            break;
+
+        int u = path[i];
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            if (G.Targets[e] == path[i + 1] && C.edgeClosed(e))
+                return false;
+    }
+    return true;
+}
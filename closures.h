@@ -0,0 +1,125 @@
+/*closures.h*/
+
+//
+// Closed footway segments and nodes (construction, events, ...).
+//
+// A closure does not change the graph.  Each map snapshot carries a
+// Closures object: the closed segments and nodes by OSM id, plus one
+// bit per CSR edge and per vertex that searches test as they relax an
+// edge.  Closures are immutable once published; closing or reopening
+// something copies the bitsets, flips the bits of just the edges
+// involved, and swaps the new object in with one atomic store, so
+// queries running meanwhile keep the set they started with.
+//
+// What a closure does to the precomputed structures:
+//
+//   - components: still a valid test.  Closing things can only
+//     disconnect vertices, so different labels still mean no route
+//     (the same label no longer promises one).
+//   - ALT landmarks: still valid.  Closures only lengthen distances,
+//     so the landmark bounds stay lower bounds and A* stays exact.
+//   - hub labels, simplified graph: their answer is checked instead.
+//     If the route they find uses nothing closed, it is also the
+//     shortest route with the closures (nothing got shorter);
+//     otherwise the query falls back to a search that honors them.
+//   - CCH weightings, CRP overlay: repaired.  Every edge that is
+//     closed or touches a closed node gets an infinite weight, and
+//     only what those edges feed is customized again: the arcs of
+//     their CCH ancestors, the overlay cells around them.  The
+//     repaired copies travel with the closures (Repaired), so a query
+//     routes on them at full speed and never sees a closed edge.
+//   - arc flags: their answer is checked, as for hub labels.  A flag
+//     set for the open map may miss the detour, and rebuilding a
+//     cell's flags takes a search per boundary vertex.
+//   - contraction hierarchy (PHAST): not used while answering
+//     queries, and not updated.
+//
+// A reload rebuilds the bits for the new graph from the OSM ids, so
+// closures survive it (a segment that is gone from the new map is
+// dropped).
+//
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <memory>
+#include <cstdint>
+
+#include "compactgraph.h"
+
+struct ClosedMetrics; // campus.h
+
+struct Closures
+{
+    std::vector<std::pair<long long, long long>> Segments; // OSM node ids, smaller first
+    std::vector<long long> Nodes;                          // OSM node ids
+    std::vector<uint64_t> EdgeBits;                        // bit e: CSR edge e is closed
+    std::vector<uint64_t> VertexBits;                      // bit v: vertex v is closed
+    std::shared_ptr<const ClosedMetrics> Repaired;         // customizations redone for these
+                                                           // closures, see repairMetrics
+
+    bool empty() const
+    {
+        return this->Segments.empty() && this->Nodes.empty();
+    }
+
+    bool edgeClosed(int e) const
+    {
+        return (this->EdgeBits[e >> 6] >> (e & 63)) & 1;
+    }
+
+    bool vertexClosed(int v) const
+    {
+        return (this->VertexBits[v >> 6] >> (v & 63)) & 1;
+    }
+
+    //
+    // blocks
+    //
+    // True if edge e (to vertex v) may not be used.
+    //
+    bool blocks(int e, int v) const
+    {
+        return this->edgeClosed(e) || this->vertexClosed(v);
+    }
+};
+
+typedef std::shared_ptr<const Closures> ClosuresPtr;
+
+//
+// activeClosures
+//
+// C itself if it closes anything, else nullptr, so that searches skip
+// the tests altogether.
+//
+inline const Closures *activeClosures(const ClosuresPtr &C)
+{
+    return C && !C->empty() ? C.get() : nullptr;
+}
+
+//
+// applyClosures
+//
+// Sets C's bits for G from its segments and nodes, dropping the ones
+// G does not have.
+//
+void applyClosures(const CompactGraph &G, Closures &C);
+
+//
+// setSegmentClosed / setNodeClosed
+//
+// Closes (or, with closed false, reopens) the footway segment between
+// two adjacent nodes, or a node, updating only the bits involved.
+// Return false if the nodes are not adjacent footway nodes / the node
+// is not on a footway.
+//
+bool setSegmentClosed(const CompactGraph &G, Closures &C, long long a, long long b, bool closed);
+bool setNodeClosed(const CompactGraph &G, Closures &C, long long id, bool closed);
+
+//
+// pathOpen
+//
+// True if path (dense vertices) uses no closed edge or vertex.
+//
+bool pathOpen(const CompactGraph &G, const Closures &C, const std::vector<int> &path);
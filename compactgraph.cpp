@@ -0,0 +1,223 @@
+/*compactgraph.cpp*/
+
+//
+// Read-only, array-based (CSR) view of the footway graph.
+//
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "dist.h"
+#include "compactgraph.h"
+
+namespace
+{
+struct Arc
+{
+    int From;
+    int To;
+    double Weight;
+};
+}
+
+//
+// buildCompactGraph
+//
+void buildCompactGraph(std::vector<FootwayInfo> &Footways,
+                       std::map<long long, Coordinates> &Nodes,
+                       CompactGraph &G)
+{
+    G = CompactGraph();
+
+    //
+    // vertices: every node that appears on a footway, numbered in
+    // increasing OSM id order (the order the map-based graph uses):
+    //
+    std::map<long long, int> onFootway;
+    for (FootwayInfo &footway : Footways)
+        for (long long id : footway.Nodes)
+            if (Nodes.count(id) > 0)
+                onFootway.emplace(id, 0);
+
+    for (auto &node : onFootway)
+    {
+        const Coordinates &c = Nodes[node.first];
+        node.second = (int)G.IDs.size();
+        G.Index.emplace(node.first, node.second);
+        G.IDs.push_back(node.first);
+        G.Lat.push_back(c.Lat);
+        G.Lon.push_back(c.Lon);
+    }
+
+    //
+    // edges, in the order addEdges would add them:
+    //
+    std::vector<Arc> arcs;
+    for (FootwayInfo &footway : Footways)
+    {
+        for (size_t i = 0; i + 1 < footway.Nodes.size(); ++i)
+        {
+            auto n1 = Nodes.find(footway.Nodes[i]);
+            auto n2 = Nodes.find(footway.Nodes[i + 1]);
+            if (n1 == Nodes.end() || n2 == Nodes.end() || n1 == n2)
+                continue;
+
+            double dist = distBetween2Points(n1->second.Lat, n1->second.Lon, n2->second.Lat, n2->second.Lon);
+
+            // acos() of a value rounded just past 1 gives NaN for nearly
+            // identical points; no search can relax such an edge (every
+            // compare against NaN fails), so leave it out
+            if (std::isnan(dist))
+                continue;
+
+            int u = G.Index[n1->first];
+            int v = G.Index[n2->first];
+            arcs.push_back(Arc{u, v, dist});
+            arcs.push_back(Arc{v, u, dist});
+        }
+    }
+
+    //
+    // group by tail, then head; like graph::addEdge, a repeated edge
+    // keeps the weight it was given last:
+    //
+    std::stable_sort(arcs.begin(), arcs.end(), [](const Arc &a, const Arc &b) {
+        if (a.From != b.From)
+            return a.From < b.From;
+        return a.To < b.To;
+    });
+
+    int n = G.NumVertices();
+    G.Offsets.assign(n + 1, 0);
+
+    for (size_t i = 0; i < arcs.size(); ++i)
+    {
+        bool lastOfGroup = (i + 1 == arcs.size() ||
+                            arcs[i + 1].From != arcs[i].From ||
+                            arcs[i + 1].To != arcs[i].To);
+        if (!lastOfGroup)
+            continue;
+
+        G.Targets.push_back(arcs[i].To);
+        G.Weights.push_back(arcs[i].Weight);
+        G.Offsets[arcs[i].From + 1]++;
+
+        int u = arcs[i].From, v = arcs[i].To;
+        double line = straightLineMiles(G.Lat[u], G.Lon[u], G.Lat[v], G.Lon[v]);
+        if (line > 0.0 && arcs[i].Weight < line * G.MinStretch)
+            G.MinStretch = arcs[i].Weight / line;
+    }
+
+    for (int v = 0; v < n; ++v)
+        G.Offsets[v + 1] += G.Offsets[v];
+}
+
+//
+// straightLineMiles
+//
+double straightLineMiles(double lat1, double lon1, double lat2, double lon2)
+{
+    const double PI = 3.14159265;
+    const double EARTH_RADIUS = 3963.1; // as in distBetween2Points
+
+    double dLat = (lat2 - lat1) * PI / 180.0;
+    double dLon = (lon2 - lon1) * PI / 180.0;
+    double a = std::sin(dLat / 2) * std::sin(dLat / 2) +
+               std::cos(lat1 * PI / 180.0) * std::cos(lat2 * PI / 180.0) *
+                   std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS * std::asin(std::sqrt(std::min(a, 1.0)));
+}
+
+//
+// quantizeWeights
+//
+void quantizeWeights(CompactGraph &G, double unitsPerMile)
+{
+    G.UnitsPerMile = unitsPerMile;
+    G.MaxIntWeight = 0;
+    G.IntWeights.resize(G.Weights.size());
+
+    for (size_t e = 0; e < G.Weights.size(); ++e)
+    {
+        double units = std::floor(G.Weights[e] * unitsPerMile + 0.5);
+        G.IntWeights[e] = (uint32_t)units;
+        if (G.IntWeights[e] > G.MaxIntWeight)
+            G.MaxIntWeight = G.IntWeights[e];
+    }
+}
+
+//
+// nearestVertex
+//
+int nearestVertex(const CompactGraph &G, double lat, double lon, bool giantOnly)
+{
+    double best = std::numeric_limits<double>::max();
+    int bestV = -1;
+    giantOnly = giantOnly && !G.Component.empty();
+
+    for (int v = 0; v < G.NumVertices(); ++v)
+    {
+        if (giantOnly && G.Component[v] != 0)
+            continue;
+
+        double d = distBetween2Points(lat, lon, G.Lat[v], G.Lon[v]);
+        if (d < best)
+        {
+            best = d;
+            bestV = v;
+        }
+    }
+    return bestV;
+}
+
+//
+// walkToNearest
+//
+int walkToNearest(const CompactGraph &G, int from, double lat, double lon)
+{
+    int v = from;
+    double best = straightLineMiles(lat, lon, G.Lat[v], G.Lon[v]);
+
+    for (bool moved = true; moved;)
+    {
+        moved = false;
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+        {
+            int w = G.Targets[e];
+            double d = straightLineMiles(lat, lon, G.Lat[w], G.Lon[w]);
+            if (d < best)
+            {
+                best = d;
+                v = w;
+                moved = true;
+                break;
+            }
+        }
+    }
+    return v;
+}
+
+//
+// graphFingerprint
+//
+uint64_t graphFingerprint(const CompactGraph &G)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    mix(G.IDs.data(), G.IDs.size() * sizeof(long long));
+    mix(G.Offsets.data(), G.Offsets.size() * sizeof(int));
+    mix(G.Targets.data(), G.Targets.size() * sizeof(int));
+    mix(G.Weights.data(), G.Weights.size() * sizeof(double));
+    return hash;
+}
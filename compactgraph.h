@@ -0,0 +1,168 @@
+/*compactgraph.h*/
+
+//
+// Read-only, array-based (CSR) view of the footway graph.
+//
+// The map-based graph class is convenient while the graph is being
+// built, but every neighbor lookup costs a tree walk and a set copy.
+// Once the map is loaded the footway graph never changes, so we lay
+// it out as flat arrays indexed by a dense vertex number 0..N-1:
+//
+//   Offsets[v] .. Offsets[v+1]-1   index the edges leaving v
+//   Targets[e], Weights[e]         head and length (miles) of edge e
+//
+// Only nodes that appear on some footway become vertices; IDs[v]
+// maps a dense vertex back to its OSM node id.  They are numbered in
+// increasing OSM id order unless reorder.h renumbers them.
+//
+// Optionally the weights are also quantized to integers (IntWeights,
+// in units of 1/UnitsPerMile miles), for searches that want integer
+// compares and bucket queues.
+//
+// Component[v] labels the connected component of v (see
+// components.h); two vertices with different labels have no route
+// between them.
+//
+// MinStretch is the least ratio of an edge's weight to the straight
+// line between its ends.  It would be 1, but distBetween2Points loses
+// precision on short edges, so some come out a hair shorter than the
+// straight line; a straight-line heuristic scaled by MinStretch stays
+// a lower bound on every path.
+//
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+#include "osm.h"
+
+const double CENTIMETERS_PER_MILE = 160934.4;
+const double MILLIMETERS_PER_MILE = 1609344.0;
+
+struct CompactGraph
+{
+    std::vector<long long> IDs; // dense vertex -> OSM node id
+    std::vector<double> Lat;
+    std::vector<double> Lon;
+    std::vector<int> Offsets; // size NumVertices()+1
+    std::vector<int> Targets;
+    std::vector<double> Weights;
+    std::unordered_map<long long, int> Index; // OSM node id -> dense vertex
+
+    std::vector<uint32_t> IntWeights; // empty unless quantized
+    double UnitsPerMile;              // 0 unless quantized
+    uint32_t MaxIntWeight;
+
+    std::vector<int> Component;     // empty unless labeled; 0 is the largest
+    std::vector<int> ComponentSize; // vertices per component
+
+    double MinStretch; // least Weights[e] / straight-line length
+
+    CompactGraph()
+    {
+        UnitsPerMile = 0.0;
+        MaxIntWeight = 0;
+        MinStretch = 1.0;
+    }
+
+    int NumVertices() const
+    {
+        return (int)this->IDs.size();
+    }
+
+    int NumEdges() const
+    {
+        return (int)this->Targets.size();
+    }
+
+    //
+    // vertexOf
+    //
+    // Returns the dense vertex for an OSM node id, or -1 if the node
+    // is not on any footway.
+    //
+    int vertexOf(long long id) const
+    {
+        auto it = this->Index.find(id);
+        if (it == this->Index.end())
+            return -1;
+        return it->second;
+    }
+
+    //
+    // sameComponent
+    //
+    // False only if u and v are known to be disconnected.
+    //
+    bool sameComponent(int u, int v) const
+    {
+        return this->Component.empty() || this->Component[u] == this->Component[v];
+    }
+};
+
+//
+// buildCompactGraph
+//
+// Builds the CSR graph from the footways, with the same edges and
+// weights that addEdges puts into the map-based graph: consecutive
+// nodes of a footway are joined in both directions, and duplicate
+// edges collapse into one.
+//
+void buildCompactGraph(std::vector<FootwayInfo> &Footways,
+                       std::map<long long, Coordinates> &Nodes,
+                       CompactGraph &G);
+
+//
+// straightLineMiles
+//
+// Great-circle distance by the haversine formula, which unlike
+// distBetween2Points stays accurate (and never NaN) for points a few
+// feet apart.
+//
+double straightLineMiles(double lat1, double lon1, double lat2, double lon2);
+
+//
+// graphFingerprint
+//
+// FNV-1a over the vertex ids, edges and weights: a table saved to disk
+// (landmarks, cells) is only valid for the graph, and the numbering,
+// it was built on.
+//
+uint64_t graphFingerprint(const CompactGraph &G);
+
+//
+// quantizeWeights
+//
+// Fills IntWeights with every weight rounded to the nearest
+// 1/unitsPerMile miles (e.g. CENTIMETERS_PER_MILE).  Each edge is off
+// by at most half a unit, so a path of k edges is off by at most k/2
+// units.
+//
+void quantizeWeights(CompactGraph &G, double unitsPerMile);
+
+//
+// nearestVertex
+//
+// Returns a dense vertex closest to (lat, lon), or -1 if the graph is
+// empty.  Of several equally close vertices it returns the first in
+// vertex order, which depends on the --order numbering.  With
+// giantOnly (and labeled components) only the largest component is
+// considered, so a building next to a stray footway fragment still
+// snaps to the network everyone else can reach.
+//
+int nearestVertex(const CompactGraph &G, double lat, double lon, bool giantOnly = false);
+
+//
+// walkToNearest
+//
+// Snaps (lat, lon) by walking from vertex from to whichever neighbor
+// is closer to it until none is.  The cost depends on how far the
+// position is from from, not on the size of the graph, which suits a
+// walker whose position moves a little at a time.  The walk can stop
+// at a vertex that is only closer than its neighbors, so a caller
+// should fall back to nearestVertex if the result is not close.
+//
+int walkToNearest(const CompactGraph &G, int from, double lat, double lon);
@@ -0,0 +1,133 @@
+/*components.cpp*/
+
+//
+// Connected components of the compact graph.
+//
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+
+#include "components.h"
+#include "threadpool.h" // defaultThreadCount
+
+namespace
+{
+class ConcurrentUnionFind
+{
+private:
+    std::unique_ptr<std::atomic<int>[]> parent;
+
+public:
+    ConcurrentUnionFind(int n)
+        : parent(new std::atomic<int>[n])
+    {
+        for (int v = 0; v < n; ++v)
+            this->parent[v] = v;
+    }
+
+    int find(int v)
+    {
+        while (true)
+        {
+            int p = this->parent[v].load();
+            if (p == v)
+                return v;
+
+            // path halving: point v at its grandparent
+            int gp = this->parent[p].load();
+            if (gp != p)
+                this->parent[v].compare_exchange_weak(p, gp);
+            v = gp;
+        }
+    }
+
+    void unite(int a, int b)
+    {
+        while (true)
+        {
+            a = this->find(a);
+            b = this->find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+
+            // a is the larger root; it fails to link only if another
+            // thread linked it meanwhile, and then we look again
+            int expected = a;
+            if (this->parent[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+};
+}
+
+//
+// labelComponents
+//
+void labelComponents(CompactGraph &G, int numThreads)
+{
+    const int PARALLEL_EDGES = 1 << 18; // below this a thread costs more than it saves
+
+    int n = G.NumVertices();
+    ConcurrentUnionFind sets(n);
+
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    if (G.NumEdges() < PARALLEL_EDGES)
+        numThreads = 1;
+
+    // every edge is stored both ways; one direction is enough
+    auto uniteRange = [&G, &sets](int begin, int end) {
+        for (int u = begin; u < end; ++u)
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (u < G.Targets[e])
+                    sets.unite(u, G.Targets[e]);
+    };
+
+    if (numThreads == 1)
+        uniteRange(0, n);
+    else
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t)
+            threads.push_back(std::thread(uniteRange, (int)((long long)n * t / numThreads),
+                                          (int)((long long)n * (t + 1) / numThreads)));
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    //
+    // number the roots by decreasing component size:
+    //
+    std::vector<int> root(n);
+    std::vector<int> size(n, 0);
+    for (int v = 0; v < n; ++v)
+    {
+        root[v] = sets.find(v);
+        size[root[v]]++;
+    }
+
+    std::vector<int> roots;
+    for (int v = 0; v < n; ++v)
+        if (root[v] == v)
+            roots.push_back(v);
+    std::stable_sort(roots.begin(), roots.end(), [&size](int a, int b) {
+        return size[a] > size[b];
+    });
+
+    std::vector<int> label(n, -1);
+    G.ComponentSize.clear();
+    for (int r : roots)
+    {
+        label[r] = (int)G.ComponentSize.size();
+        G.ComponentSize.push_back(size[r]);
+    }
+
+    G.Component.resize(n);
+    for (int v = 0; v < n; ++v)
+        G.Component[v] = label[root[v]];
+}
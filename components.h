@@ -0,0 +1,32 @@
+/*components.h*/
+
+//
+// Connected components of the compact graph.
+//
+// A route between two vertices in different components does not
+// exist, and finding that out with a search means settling the whole
+// component of the start first.  Labeling the components once, when
+// the map is loaded, turns that into one compare.
+//
+// The labels come from a union-find over the edges.  Threads share
+// one parent array of atomics: a union links the root with the larger
+// index below the one with the smaller index using a compare-and-swap
+// (retrying if another thread linked it first), and finds halve the
+// path as they go.  Links only ever point to smaller indices, so no
+// cycle can form however the threads interleave.
+//
+// Components are numbered by decreasing size (ties by their smallest
+// vertex), so component 0 is the giant component.
+//
+
+#pragma once
+
+#include "compactgraph.h"
+
+//
+// labelComponents
+//
+// Fills G.Component and G.ComponentSize.  numThreads <= 0 means one
+// per core; small graphs are labeled on the calling thread.
+//
+void labelComponents(CompactGraph &G, int numThreads = 0);
@@ -0,0 +1,339 @@
+/*crp.cpp*/
+
+//
+// Customizable route planning on a multi-level cell overlay.
+//
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+#include "crp.h"
+#include "threadpool.h"
+
+//
+// cellSearch
+//
+// Dijkstra from source inside cell of the given level: on the footways
+// for level 0, otherwise on the cliques and cut edges of the level
+// below.  Stops once target (if any) is settled; W is reset first.
+//
+static void cellSearch(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                       const CrpMetric &M, int level, int cell, int source, int target,
+                       SearchWorkspace &W)
+{
+    W.reset();
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+    queue.clear();
+
+    auto relax = [&W, &queue](int u, int v, double alt) {
+        if (alt < W.Dist[v])
+        {
+            W.touch(v);
+            W.Dist[v] = alt;
+            W.Pred[v] = u;
+            queue.update(v, alt);
+        }
+    };
+
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    queue.update(source, 0.0);
+    const std::vector<int> &cells = P.Cells[level];
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+        int u = current.second;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+        if (u == target)
+            break;
+
+        if (level == 0)
+        {
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (cells[G.Targets[e]] == cell)
+                    relax(u, G.Targets[e], current.first + M.EdgeWeights[e]);
+            continue;
+        }
+
+        // across u's cell one level down, then out of it
+        const CrpLevel &below = O.Levels[level - 1];
+        const std::vector<double> &clique = M.Cliques[level - 1];
+        int sub = P.Cells[level - 1][u];
+        int first = below.CellOffsets[sub];
+        int k = below.CellOffsets[sub + 1] - first;
+        size_t row = below.CliqueOffsets[sub] + (size_t)below.Position[u] * k;
+        for (int j = 0; j < k; ++j)
+            if (clique[row + j] != INF_DIST)
+                relax(u, below.Boundary[first + j], current.first + clique[row + j]);
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            if (P.Cells[level - 1][v] != sub && cells[v] == cell)
+                relax(u, v, current.first + M.EdgeWeights[e]);
+        }
+    }
+}
+
+//
+// buildCrpOverlay
+//
+void buildCrpOverlay(const CompactGraph &G, const Partition &P, CrpOverlay &O)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int n = G.NumVertices();
+    O = CrpOverlay();
+    O.Levels.resize(P.NumLevels());
+
+    for (int level = 0; level < P.NumLevels(); ++level)
+    {
+        const std::vector<int> &cells = P.Cells[level];
+        CrpLevel &L = O.Levels[level];
+        int numCells = P.NumCells[level];
+
+        std::vector<char> boundary(n, 0);
+        L.CellOffsets.assign(numCells + 1, 0);
+        for (int u = 0; u < n; ++u)
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (cells[G.Targets[e]] != cells[u])
+                {
+                    boundary[u] = 1;
+                    L.CellOffsets[cells[u] + 1]++;
+                    break;
+                }
+        for (int c = 0; c < numCells; ++c)
+            L.CellOffsets[c + 1] += L.CellOffsets[c];
+
+        L.Boundary.resize(L.CellOffsets[numCells]);
+        L.Position.assign(n, -1);
+        std::vector<int> fill(L.CellOffsets.begin(), L.CellOffsets.end() - 1);
+        for (int u = 0; u < n; ++u)
+            if (boundary[u])
+            {
+                int c = cells[u];
+                L.Position[u] = fill[c] - L.CellOffsets[c];
+                L.Boundary[fill[c]++] = u;
+            }
+
+        L.CliqueOffsets.assign(numCells + 1, 0);
+        for (int c = 0; c < numCells; ++c)
+        {
+            size_t k = L.CellOffsets[c + 1] - L.CellOffsets[c];
+            L.CliqueOffsets[c + 1] = L.CliqueOffsets[c] + k * k;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    O.BuildSeconds = elapsed.count();
+}
+
+//
+// customizeCell
+//
+// Fills the clique of one cell: a search from each boundary vertex.
+//
+static void customizeCell(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                          CrpMetric &M, int level, int cell, SearchWorkspace &W)
+{
+    const CrpLevel &L = O.Levels[level];
+    int first = L.CellOffsets[cell];
+    int k = L.CellOffsets[cell + 1] - first;
+    double *clique = M.Cliques[level].data() + L.CliqueOffsets[cell];
+
+    for (int i = 0; i < k; ++i)
+    {
+        cellSearch(G, P, O, M, level, cell, L.Boundary[first + i], -1, W);
+        for (int j = 0; j < k; ++j)
+            clique[(size_t)i * k + j] = W.Dist[L.Boundary[first + j]];
+    }
+}
+
+//
+// customizeCrp
+//
+void customizeCrp(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                  const std::vector<double> &edgeWeights, CrpMetric &M, int numThreads)
+{
+    auto start = std::chrono::steady_clock::now();
+    M.EdgeWeights = edgeWeights;
+    M.Cliques.resize(O.NumLevels());
+
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    std::vector<SearchWorkspace> workspaces(numThreads);
+    for (SearchWorkspace &W : workspaces)
+        W.init(G.NumVertices());
+    std::unique_ptr<WorkStealingPool> pool;
+    if (numThreads > 1)
+        pool.reset(new WorkStealingPool(numThreads));
+
+    // each level is computed on the one below, so levels go in order
+    for (int level = 0; level < O.NumLevels(); ++level)
+    {
+        const CrpLevel &L = O.Levels[level];
+        size_t numCells = L.CellOffsets.size() - 1;
+        M.Cliques[level].assign(L.CliqueOffsets[numCells], INF_DIST);
+
+        if (!pool)
+        {
+            for (size_t c = 0; c < numCells; ++c)
+                customizeCell(G, P, O, M, level, (int)c, workspaces[0]);
+            continue;
+        }
+
+        pool->parallelFor(numCells, 1, [&](size_t begin, size_t end, int worker) {
+            for (size_t c = begin; c < end; ++c)
+                customizeCell(G, P, O, M, level, (int)c, workspaces[worker]);
+        });
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    M.CustomizeSeconds = elapsed.count();
+}
+
+//
+// recustomizeCrp
+//
+void recustomizeCrp(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                    const std::vector<int> &vertices, CrpMetric &M)
+{
+    SearchWorkspace W;
+    W.init(G.NumVertices());
+
+    for (int level = 0; level < O.NumLevels(); ++level)
+    {
+        std::vector<int> cells;
+        for (int v : vertices)
+            cells.push_back(P.Cells[level][v]);
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+        for (int c : cells)
+            customizeCell(G, P, O, M, level, c, W);
+    }
+}
+
+//
+// queryLevel
+//
+// The level v is searched on in a query from source to target: one
+// below the lowest level on which v shares a cell with either, -1 (the
+// footways) if that is level 0.
+//
+static int queryLevel(const Partition &P, int v, int source, int target)
+{
+    for (int level = 0; level < P.NumLevels(); ++level)
+    {
+        const std::vector<int> &cells = P.Cells[level];
+        if (cells[v] == cells[source] || cells[v] == cells[target])
+            return level - 1;
+    }
+    return P.NumLevels() - 1;
+}
+
+//
+// unpackArc
+//
+// Appends the footway path of the clique arc a -> b of cell on level
+// (without a itself) to path.
+//
+static void unpackArc(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                      const CrpMetric &M, int level, int cell, int a, int b, SearchWorkspace &W,
+                      std::vector<int> &path)
+{
+    cellSearch(G, P, O, M, level, cell, a, b, W);
+    std::vector<int> hops = traceCompactPath(W.Pred, a, b);
+
+    for (size_t i = 0; i + 1 < hops.size(); ++i)
+    {
+        int x = hops[i], y = hops[i + 1];
+        if (level > 0 && P.Cells[level - 1][x] == P.Cells[level - 1][y])
+            unpackArc(G, P, O, M, level - 1, P.Cells[level - 1][x], x, y, W, path);
+        else
+            path.push_back(y); // a footway edge
+    }
+}
+
+//
+// crpRoute
+//
+bool crpRoute(const CompactGraph &G, const Partition &P, const CrpOverlay &O, const CrpMetric &M,
+              int source, int target, SearchWorkspace &W, std::vector<int> &path, double &miles)
+{
+    path.clear();
+    W.reset();
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+    queue.clear();
+
+    auto relax = [&W, &queue](int u, int v, double alt) {
+        if (alt < W.Dist[v])
+        {
+            W.touch(v);
+            W.Dist[v] = alt;
+            W.Pred[v] = u;
+            queue.update(v, alt);
+        }
+    };
+
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    queue.update(source, 0.0);
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+        int u = current.second;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+        if (u == target)
+            break;
+
+        int level = queryLevel(P, u, source, target);
+        if (level < 0)
+        {
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                relax(u, G.Targets[e], current.first + M.EdgeWeights[e]);
+            continue;
+        }
+
+        // across u's cell on its level, then out of it
+        const CrpLevel &L = O.Levels[level];
+        const std::vector<double> &clique = M.Cliques[level];
+        int cell = P.Cells[level][u];
+        int first = L.CellOffsets[cell];
+        int k = L.CellOffsets[cell + 1] - first;
+        size_t row = L.CliqueOffsets[cell] + (size_t)L.Position[u] * k;
+        for (int j = 0; j < k; ++j)
+            if (clique[row + j] != INF_DIST)
+                relax(u, L.Boundary[first + j], current.first + clique[row + j]);
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            if (P.Cells[level][G.Targets[e]] != cell)
+                relax(u, G.Targets[e], current.first + M.EdgeWeights[e]);
+    }
+
+    if (!W.Settled[target])
+        return false;
+    miles = W.Dist[target];
+
+    // the overlay route, then every clique arc on it down to footways
+    std::vector<int> hops = traceCompactPath(W.Pred, source, target);
+    long long settled = W.NumSettled;
+    path.push_back(source);
+    for (size_t i = 0; i + 1 < hops.size(); ++i)
+    {
+        int x = hops[i], y = hops[i + 1];
+        int level = queryLevel(P, x, source, target);
+        if (level >= 0 && P.Cells[level][x] == P.Cells[level][y])
+            unpackArc(G, P, O, M, level, P.Cells[level][x], x, y, W, path);
+        else
+            path.push_back(y);
+    }
+    W.NumSettled = settled; // the query's own search
+    return true;
+}
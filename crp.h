@@ -0,0 +1,114 @@
+/*crp.h*/
+
+//
+// Customizable route planning (CRP): a multi-level overlay of the
+// cells of a Partition (partition.h).
+//
+// The boundary vertices of a cell are those with an edge leaving it.
+// For every cell on every level the overlay keeps a clique: the
+// shortest distance, inside the cell, between every two of its
+// boundary vertices.  A level-0 clique is computed on the footways of
+// its cell; a clique higher up on the level below it, whose cliques
+// and cut edges already stand for everything inside.  Only the cliques
+// depend on the weights, so customizing for new weights is one pass
+// over the levels, with the cells of a level in parallel.
+//
+// A query is one Dijkstra search that changes levels as it goes.  A
+// vertex in the level-0 cell of the source or the target is searched
+// on the footways around it.  Any other vertex is searched on the
+// highest level whose cell around it contains neither the source nor
+// the target: across its cell by the clique, out of it by the cut
+// edges.  So the search walks the footways only near the two ends and
+// crosses everything in between in large steps.  The clique arcs on
+// the route found are unpacked by searching their cells again, level
+// by level, down to the footways.
+//
+// Delling, Goldberg, Pajor and Werneck, "Customizable Route Planning"
+// (SEA 2011).
+//
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "compactgraph.h"
+#include "partition.h"
+#include "search.h"
+
+struct CrpLevel
+{
+    std::vector<int> CellOffsets;      // Boundary[CellOffsets[c] .. CellOffsets[c+1]-1]
+    std::vector<int> Boundary;         // are the boundary vertices of cell c
+    std::vector<int> Position;         // vertex -> its index there, -1 if not boundary
+    std::vector<size_t> CliqueOffsets; // cell c's k*k distances start here
+};
+
+struct CrpOverlay
+{
+    std::vector<CrpLevel> Levels; // one per partition level, finest first
+    double BuildSeconds;
+
+    CrpOverlay()
+    {
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->Levels.empty();
+    }
+
+    int NumLevels() const
+    {
+        return (int)this->Levels.size();
+    }
+};
+
+struct CrpMetric
+{
+    std::vector<double> EdgeWeights;          // the weights, per CompactGraph edge
+    std::vector<std::vector<double>> Cliques; // per level, row-major per cell
+    double CustomizeSeconds;
+
+    CrpMetric()
+    {
+        CustomizeSeconds = 0.0;
+    }
+};
+
+//
+// buildCrpOverlay
+//
+// Finds the boundary vertices of every cell of P and lays out the
+// cliques; nothing here depends on the weights.
+//
+void buildCrpOverlay(const CompactGraph &G, const Partition &P, CrpOverlay &O);
+
+//
+// customizeCrp
+//
+// Computes the cliques of O for edgeWeights (one per edge of G) into
+// M, on numThreads threads (<= 0: one per core).
+//
+void customizeCrp(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                  const std::vector<double> &edgeWeights, CrpMetric &M, int numThreads = 0);
+
+//
+// recustomizeCrp
+//
+// Brings M up to date after M.EdgeWeights changed at the edges around
+// the given vertices: only the cells containing one of them are
+// customized again, level by level.
+//
+void recustomizeCrp(const CompactGraph &G, const Partition &P, const CrpOverlay &O,
+                    const std::vector<int> &vertices, CrpMetric &M);
+
+//
+// crpRoute
+//
+// Shortest route from source to target (dense vertices) under M, using
+// W for scratch.  Returns false if there is none.
+//
+bool crpRoute(const CompactGraph &G, const Partition &P, const CrpOverlay &O, const CrpMetric &M,
+              int source, int target, SearchWorkspace &W, std::vector<int> &path, double &miles);
@@ -0,0 +1,293 @@
+/*dstarlite.cpp*/
+
+//
+// D* Lite replanning.
+//
+
+#include <vector>
+#include <algorithm>
+
+#include "dstarlite.h"
+#include "search.h"
+
+// shaved off the heuristic so that rounding never breaks consistency
+const double HEURISTIC_SCALE = 1.0 - 1e-9;
+
+static double addDist(double a, double b)
+{
+    return (a == INF_DIST || b == INF_DIST) ? INF_DIST : a + b;
+}
+
+double DStarLite::heuristic(int a, int b) const
+{
+    return this->scale * straightLineMiles(this->G->Lat[a], this->G->Lon[a], this->G->Lat[b], this->G->Lon[b]);
+}
+
+//
+// cost
+//
+// Length of edge e into v, INF_DIST if it is closed.  Closures close
+// both directions of a segment, so for e = v -> u this is also the
+// length of u -> v, which is what the backward search needs.
+//
+double DStarLite::cost(int e, int v) const
+{
+    const Closures *closed = activeClosures(this->closures);
+    return (closed && closed->blocks(e, v)) ? INF_DIST : this->G->Weights[e];
+}
+
+DStarLite::Key DStarLite::key(int v) const
+{
+    double m = std::min(this->g[v], this->rhs[v]);
+    if (m == INF_DIST)
+        return Key(INF_DIST, INF_DIST);
+    return Key(m + this->heuristic(this->start, v) + this->km, m);
+}
+
+//
+// lookahead
+//
+// rhs of u: the best step to a neighbor plus that neighbor's g.
+//
+double DStarLite::lookahead(int u) const
+{
+    if (u == this->goal)
+        return 0.0;
+
+    double best = INF_DIST;
+    for (int e = this->G->Offsets[u]; e < this->G->Offsets[u + 1]; ++e)
+    {
+        int v = this->G->Targets[e];
+        best = std::min(best, addDist(this->cost(e, v), this->g[v]));
+    }
+    return best;
+}
+
+void DStarLite::updateVertex(int v)
+{
+    if (this->g[v] != this->rhs[v])
+        this->queue.set(v, this->key(v));
+    else
+        this->queue.remove(v);
+}
+
+//
+// search
+//
+// ComputeShortestPath: expands vertices until the start is settled
+// and nothing queued could still improve it.
+//
+void DStarLite::search()
+{
+    const CompactGraph &G = *this->G;
+    int s = this->start;
+
+    while (!this->queue.empty() &&
+           (this->queue.top().first < this->key(s) || this->rhs[s] > this->g[s]))
+    {
+        int u = this->queue.top().second;
+        Key old = this->queue.top().first;
+        Key now = this->key(u);
+        this->Expanded++;
+
+        if (old < now)
+        {
+            // queued before the start moved; just correct its key
+            this->queue.set(u, now);
+        }
+        else if (this->g[u] > this->rhs[u])
+        {
+            this->g[u] = this->rhs[u];
+            this->queue.remove(u);
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            {
+                int p = G.Targets[e];
+                if (p == this->goal)
+                    continue;
+                double via = addDist(this->cost(e, u), this->g[u]);
+                if (via < this->rhs[p])
+                {
+                    this->rhs[p] = via;
+                    this->updateVertex(p);
+                }
+            }
+        }
+        else
+        {
+            double gOld = this->g[u];
+            this->g[u] = INF_DIST;
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            {
+                int p = G.Targets[e];
+                if (p != this->goal && this->rhs[p] == addDist(this->cost(e, u), gOld))
+                {
+                    this->rhs[p] = this->lookahead(p);
+                    this->updateVertex(p);
+                }
+            }
+            this->updateVertex(u);
+        }
+    }
+}
+
+//
+// init
+//
+void DStarLite::init(const CompactGraph &G, int start, int goal, const ClosuresPtr &closures)
+{
+    this->G = &G;
+    this->closures = closures;
+    this->start = start;
+    this->goal = goal;
+    this->last = start;
+    this->km = 0.0;
+    this->Expanded = 0;
+    this->TotalExpanded = 0;
+
+    this->scale = G.MinStretch * HEURISTIC_SCALE;
+    this->g.assign(G.NumVertices(), INF_DIST);
+    this->rhs.assign(G.NumVertices(), INF_DIST);
+    this->queue.init(G.NumVertices());
+
+    this->rhs[goal] = 0.0;
+    this->queue.set(goal, this->key(goal));
+}
+
+//
+// moveStart
+//
+void DStarLite::moveStart(int start)
+{
+    if (start == this->start)
+        return;
+
+    this->start = start;
+    this->km += this->heuristic(this->last, start);
+    this->last = start;
+}
+
+//
+// updateClosures
+//
+int DStarLite::updateClosures(const ClosuresPtr &closures)
+{
+    if (closures == this->closures)
+        return 0;
+
+    const CompactGraph &G = *this->G;
+    ClosuresPtr previous = this->closures; // kept alive while diffing
+    const Closures *before = activeClosures(previous);
+    const Closures *after = activeClosures(closures);
+    this->closures = closures;
+
+    // a set with nothing closed may have no bits at all
+    static const std::vector<uint64_t> none;
+    const std::vector<uint64_t> &edgesBefore = before ? before->EdgeBits : none;
+    const std::vector<uint64_t> &edgesAfter = after ? after->EdgeBits : none;
+    const std::vector<uint64_t> &verticesBefore = before ? before->VertexBits : none;
+    const std::vector<uint64_t> &verticesAfter = after ? after->VertexBits : none;
+    auto word = [](const std::vector<uint64_t> &bits, size_t i) -> uint64_t {
+        return i < bits.size() ? bits[i] : 0;
+    };
+
+    std::vector<int> affected; // vertices whose rhs may have changed
+    int changed = 0;
+
+    size_t edgeWords = (G.NumEdges() + 63) / 64;
+    for (size_t i = 0; i < edgeWords; ++i)
+    {
+        uint64_t diff = word(edgesBefore, i) ^ word(edgesAfter, i);
+        for (; diff != 0; diff &= diff - 1)
+        {
+            int e = (int)(i * 64) + __builtin_ctzll(diff);
+            int u = (int)(std::upper_bound(G.Offsets.begin(), G.Offsets.end(), e) - G.Offsets.begin()) - 1;
+            affected.push_back(u);
+            changed++;
+        }
+    }
+
+    size_t vertexWords = (G.NumVertices() + 63) / 64;
+    for (size_t i = 0; i < vertexWords; ++i)
+    {
+        uint64_t diff = word(verticesBefore, i) ^ word(verticesAfter, i);
+        for (; diff != 0; diff &= diff - 1)
+        {
+            // every edge into v changed
+            int v = (int)(i * 64) + __builtin_ctzll(diff);
+            for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            {
+                affected.push_back(G.Targets[e]);
+                changed++;
+            }
+        }
+    }
+
+    for (int u : affected)
+    {
+        if (u == this->goal)
+            continue;
+        this->rhs[u] = this->lookahead(u);
+        this->updateVertex(u);
+    }
+    return changed;
+}
+
+//
+// replan
+//
+bool DStarLite::replan()
+{
+    this->Expanded = 0;
+    this->search();
+    this->TotalExpanded += this->Expanded;
+
+    const Closures *closed = activeClosures(this->closures);
+    if (closed && closed->vertexClosed(this->start))
+        return false;
+    return this->rhs[this->start] != INF_DIST;
+}
+
+//
+// path
+//
+std::vector<int> DStarLite::path() const
+{
+    const CompactGraph &G = *this->G;
+    std::vector<int> path;
+    if (this->rhs[this->start] == INF_DIST)
+        return path;
+
+    // step to the best neighbor until the goal; the cap only guards
+    // against a cycle of equal steps
+    int u = this->start;
+    path.push_back(u);
+    while (u != this->goal && (int)path.size() <= G.NumVertices())
+    {
+        int next = -1;
+        double best = INF_DIST;
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            double via = addDist(this->cost(e, v), this->g[v]);
+            if (via < best)
+            {
+                best = via;
+                next = v;
+            }
+        }
+        if (next < 0)
+            return std::vector<int>();
+        u = next;
+        path.push_back(u);
+    }
+    return path;
+}
+
+//
+// miles
+//
+double DStarLite::miles() const
+{
+    // the search may stop before settling the start itself
+    return this->rhs[this->start];
+}
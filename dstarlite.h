@@ -0,0 +1,135 @@
+/*dstarlite.h*/
+
+//
+// D* Lite: keeping a route up to date for a walker on the move.
+//
+// The destination stays fixed while the start moves every few seconds
+// and, now and then, a footway closes or reopens.  Rather than search
+// again each time, a DStarLite keeps its search between requests.  It
+// searches backward from the destination, so its tree is rooted where
+// the route ends and stays valid wherever the walker goes.  Every
+// vertex has a distance g and a one-step lookahead rhs (the best
+// neighbor's g plus the edge), and only vertices where the two
+// disagree are queued.  Then
+//
+//   - moving the start costs nothing if the new start is already
+//     settled (the walker is on or near the last route) and otherwise
+//     only the vertices between it and the settled part of the tree;
+//     the keys still queued are corrected lazily through the km offset
+//     instead of being recomputed, and
+//   - a closure or reopening requeues just the vertices next to it,
+//     and the search repairs the tree from there out to the start.
+//
+// The search is guided toward the start by the straight-line distance,
+// which never overestimates since every edge is at least as long as
+// the straight line between its ends (up to rounding; see MinStretch
+// in compactgraph.h).
+//
+// Koenig and Likhachev, "D* Lite" (AAAI 2002), the optimized version.
+//
+
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "compactgraph.h"
+#include "closures.h"
+#include "pqueue.h"
+
+// what a DStarLite keeps for every vertex of its graph: g, rhs and the
+// queue's position index (the queue itself holds only the vertices
+// whose g and rhs disagree)
+const size_t DSTAR_BYTES_PER_VERTEX = 2 * sizeof(double) + sizeof(int);
+
+class DStarLite
+{
+private:
+    typedef std::pair<double, double> Key;
+
+    const CompactGraph *G;
+    ClosuresPtr closures; // the closures the tree is built for
+    int start;
+    int goal;
+    int last;   // start when km was last brought up to date
+    double km;  // added to every key since the start began to move
+    double scale; // heuristic = scale * straight-line distance
+
+    std::vector<double> g;
+    std::vector<double> rhs;
+    IndexedDaryHeap<4, Key> queue;
+
+    double heuristic(int a, int b) const;
+    double cost(int e, int v) const;
+    Key key(int v) const;
+    double lookahead(int u) const;
+    void updateVertex(int v);
+    void search();
+
+public:
+    long long Expanded;      // vertices expanded by the last replan
+    long long TotalExpanded; // and by all of them since init
+
+    DStarLite()
+    {
+        G = nullptr;
+        start = -1;
+        goal = -1;
+        last = -1;
+        km = 0.0;
+        scale = 1.0;
+        Expanded = 0;
+        TotalExpanded = 0;
+    }
+
+    //
+    // init
+    //
+    // Starts over on G: a route from start to goal avoiding closures.
+    // Nothing is searched until replan.
+    //
+    void init(const CompactGraph &G, int start, int goal, const ClosuresPtr &closures);
+
+    //
+    // moveStart
+    //
+    // The walker is now at vertex start.
+    //
+    void moveStart(int start);
+
+    //
+    // updateClosures
+    //
+    // Switches to another closure set, requeueing only the vertices
+    // next to the segments and nodes that changed.  Returns how many
+    // edges changed.
+    //
+    int updateClosures(const ClosuresPtr &closures);
+
+    //
+    // replan
+    //
+    // Brings the tree up to date as far as the start needs it.  Returns
+    // false if the goal cannot be reached from the start.
+    //
+    bool replan();
+
+    //
+    // path
+    //
+    // The route from the start to the goal (dense vertices) after a
+    // successful replan, and its length.
+    //
+    std::vector<int> path() const;
+    double miles() const;
+
+    int Start() const
+    {
+        return this->start;
+    }
+
+    int Goal() const
+    {
+        return this->goal;
+    }
+};
@@ -0,0 +1,247 @@
+/*hublabels.cpp*/
+
+//
+// Hub labeling (pruned landmark labeling).
+//
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+
+#include "hublabels.h"
+#include "search.h"
+
+namespace
+{
+struct LabelEntry
+{
+    int Hub;
+    double Dist;
+    int Parent;
+};
+}
+
+//
+// importanceOrder
+//
+// Vertices by decreasing number of descendants, summed over shortest-
+// path trees from a few random roots: a vertex that many shortest
+// paths run through covers many pairs, so it should be a hub early.
+//
+static std::vector<int> importanceOrder(const CompactGraph &G, SearchWorkspace &W)
+{
+    const int SAMPLES = 64;
+
+    int n = G.NumVertices();
+    std::vector<long long> score(n, 0);
+    std::vector<long long> subtree(n);
+    std::vector<int> byDist;
+    std::mt19937 random(20120417);
+
+    for (int s = 0; s < SAMPLES && n > 0; ++s)
+    {
+        dijkstraSearch(G, random() % n, W);
+
+        byDist.clear();
+        for (int v : W.Touched)
+            if (W.Settled[v])
+            {
+                subtree[v] = 1;
+                byDist.push_back(v);
+            }
+        std::sort(byDist.begin(), byDist.end(), [&W](int a, int b) {
+            return W.Dist[a] > W.Dist[b];
+        });
+
+        for (int v : byDist)
+        {
+            if (W.Pred[v] >= 0)
+                subtree[W.Pred[v]] += subtree[v];
+            score[v] += subtree[v];
+        }
+    }
+
+    std::vector<int> order(n);
+    for (int v = 0; v < n; ++v)
+        order[v] = v;
+    std::stable_sort(order.begin(), order.end(), [&G, &score](int a, int b) {
+        if (score[a] != score[b])
+            return score[a] > score[b];
+        return G.Offsets[a + 1] - G.Offsets[a] > G.Offsets[b + 1] - G.Offsets[b];
+    });
+    return order;
+}
+
+//
+// buildHubLabels
+//
+void buildHubLabels(const CompactGraph &G, HubLabels &H, bool withPaths)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    H = HubLabels();
+    int n = G.NumVertices();
+
+    SearchWorkspace W;
+    W.init(n);
+
+    H.Order = importanceOrder(G, W);
+    H.Rank.assign(n, -1);
+    for (int k = 0; k < n; ++k)
+        H.Rank[H.Order[k]] = k;
+
+    std::vector<std::vector<LabelEntry>> labels(n);
+    std::vector<double> rootLabel(n, INF_DIST); // by hub rank: the root's label, spread out
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+
+    for (int k = 0; k < n; ++k)
+    {
+        int root = H.Order[k];
+        for (const LabelEntry &entry : labels[root])
+            rootLabel[entry.Hub] = entry.Dist;
+
+        W.reset();
+        queue.clear();
+        W.touch(root);
+        W.Dist[root] = 0.0;
+        queue.update(root, 0.0);
+
+        while (!queue.empty())
+        {
+            std::pair<double, int> current = queue.pop();
+            int u = current.second;
+            double d = current.first;
+            W.Settled[u] = 1;
+
+            //
+            // prune: if an earlier hub already gives dist(root, u),
+            // nothing beyond u needs this root either
+            //
+            bool covered = false;
+            for (const LabelEntry &entry : labels[u])
+            {
+                if (rootLabel[entry.Hub] + entry.Dist <= d)
+                {
+                    covered = true;
+                    break;
+                }
+            }
+            if (covered)
+                continue;
+
+            labels[u].push_back(LabelEntry{k, d, W.Pred[u]});
+
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            {
+                int v = G.Targets[e];
+                double alt = d + G.Weights[e];
+                if (!W.Settled[v] && alt < W.Dist[v])
+                {
+                    W.touch(v);
+                    W.Dist[v] = alt;
+                    W.Pred[v] = u;
+                    queue.update(v, alt);
+                }
+            }
+        }
+
+        for (const LabelEntry &entry : labels[root])
+            rootLabel[entry.Hub] = INF_DIST;
+    }
+
+    //
+    // pack into one CSR:
+    //
+    H.Offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v)
+        H.Offsets[v + 1] = H.Offsets[v] + (int)labels[v].size();
+
+    H.Hubs.reserve(H.Offsets[n]);
+    H.Dists.reserve(H.Offsets[n]);
+    if (withPaths)
+        H.Parents.reserve(H.Offsets[n]);
+
+    for (int v = 0; v < n; ++v)
+    {
+        for (const LabelEntry &entry : labels[v])
+        {
+            H.Hubs.push_back(entry.Hub);
+            H.Dists.push_back(entry.Dist);
+            if (withPaths)
+                H.Parents.push_back(entry.Parent);
+        }
+        std::vector<LabelEntry>().swap(labels[v]);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    H.BuildSeconds = elapsed.count();
+}
+
+//
+// hubDistance
+//
+double hubDistance(const HubLabels &H, int u, int v, int *hub)
+{
+    int i = H.Offsets[u], iEnd = H.Offsets[u + 1];
+    int j = H.Offsets[v], jEnd = H.Offsets[v + 1];
+
+    double best = INF_DIST;
+    int bestHub = -1;
+    // the advance is branch-free: which list steps is hard to predict
+    while (i < iEnd && j < jEnd)
+    {
+        int a = H.Hubs[i];
+        int b = H.Hubs[j];
+        if (a == b)
+        {
+            double d = H.Dists[i] + H.Dists[j];
+            if (d < best)
+            {
+                best = d;
+                bestHub = a;
+            }
+        }
+        i += (a <= b);
+        j += (b <= a);
+    }
+
+    if (hub != nullptr)
+        *hub = bestHub;
+    return best;
+}
+
+//
+// parentToward
+//
+// The next vertex from v toward hub (a rank in v's label).
+//
+static int parentToward(const HubLabels &H, int v, int hub)
+{
+    auto first = H.Hubs.begin() + H.Offsets[v];
+    auto last = H.Hubs.begin() + H.Offsets[v + 1];
+    auto it = std::lower_bound(first, last, hub);
+    return H.Parents[it - H.Hubs.begin()];
+}
+
+//
+// hubPath
+//
+std::vector<int> hubPath(const HubLabels &H, int u, int v)
+{
+    std::vector<int> path;
+    int hub;
+    if (hubDistance(H, u, v, &hub) == INF_DIST)
+        return path;
+
+    int meet = H.Order[hub];
+    for (int x = u; x != meet; x = parentToward(H, x, hub))
+        path.push_back(x);
+    path.push_back(meet);
+
+    std::vector<int> back;
+    for (int x = v; x != meet; x = parentToward(H, x, hub))
+        back.push_back(x);
+    path.insert(path.end(), back.rbegin(), back.rend());
+    return path;
+}
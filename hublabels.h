@@ -0,0 +1,94 @@
+/*hublabels.h*/
+
+//
+// Hub labeling (pruned landmark labeling) for distance queries that
+// need no search at all.
+//
+// Every vertex v gets a label: a list of (hub, dist(v, hub)) pairs,
+// chosen so that for any two vertices u and v some shortest u-v path
+// passes through a hub that is in both labels.  Then
+//
+//   dist(u, v) = min over common hubs h of dist(u, h) + dist(h, v)
+//
+// and because labels are sorted by hub, the common hubs are found by
+// one merge of the two lists -- a few dozen memory reads, no queue,
+// no workspace.
+//
+// The labels are built by a pruned Dijkstra search from every vertex,
+// most important first.  The search from the k-th vertex r skips any
+// vertex u whose distance the labels of the first k-1 searches already
+// answer, so later searches stay small; each vertex u it does settle
+// gets (r, dist(u, r)) appended to its label, which keeps every label
+// sorted by rank.  Vertices are ranked by how many shortest paths
+// pass through them in a few sampled shortest-path trees (with degree
+// as the tie-break): on footway maps, junctions on the main walkways.
+//
+// For path recovery every entry also records the next vertex toward
+// its hub; that vertex has the same hub in its label, so a path is
+// unpacked one hop at a time from both ends toward the meeting hub.
+//
+// Storage is one CSR over all labels: Offsets[v] .. Offsets[v+1]-1
+// index Hubs (ranks), Dists and, if built with paths, Parents.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "compactgraph.h"
+
+struct HubLabels
+{
+    std::vector<int> Rank;    // vertex -> rank (0 = most important)
+    std::vector<int> Order;   // rank -> vertex
+    std::vector<int> Offsets; // size N+1
+    std::vector<int> Hubs;    // hub ranks, ascending within a label
+    std::vector<double> Dists;
+    std::vector<int> Parents; // next vertex toward the hub; empty unless built with paths
+    double BuildSeconds;
+
+    HubLabels()
+    {
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->Offsets.empty();
+    }
+
+    size_t NumEntries() const
+    {
+        return this->Hubs.size();
+    }
+
+    size_t bytes() const
+    {
+        return this->Offsets.size() * sizeof(int) + this->Hubs.size() * sizeof(int) +
+               this->Dists.size() * sizeof(double) + this->Parents.size() * sizeof(int);
+    }
+};
+
+//
+// buildHubLabels
+//
+// Builds the labels of G (which must be symmetric).  withPaths also
+// records Parents, so that hubPath works.
+//
+void buildHubLabels(const CompactGraph &G, HubLabels &H, bool withPaths);
+
+//
+// hubDistance
+//
+// dist(u, v) by merging the two labels; INF_DIST if v is unreachable.
+// If hub is not null it receives the rank of the hub on the path.
+//
+double hubDistance(const HubLabels &H, int u, int v, int *hub = nullptr);
+
+//
+// hubPath
+//
+// The shortest path from u to v as dense vertices (empty if v is
+// unreachable).  Needs labels built with paths.
+//
+std::vector<int> hubPath(const HubLabels &H, int u, int v);
@@ -0,0 +1,100 @@
+/*isochrone.cpp*/
+
+//
+// Isochrones: everything within a walking distance of a start.
+//
+
+#include <vector>
+#include <algorithm>
+
+#include "isochrone.h"
+
+//
+// computeIsochrone
+//
+void computeIsochrone(const CompactGraph &G, int source, double radius,
+                      SearchWorkspace &W, Isochrone &iso, bool withPolygon,
+                      const Closures *closed)
+{
+    iso = Isochrone();
+    iso.Source = source;
+    iso.Radius = radius;
+
+    boundedSearch(G, source, radius, W, closed);
+
+    for (int v : W.Touched)
+        if (W.Settled[v])
+            iso.Reached.push_back(v);
+    std::sort(iso.Reached.begin(), iso.Reached.end(), [&W](int a, int b) {
+        return W.Dist[a] < W.Dist[b];
+    });
+    for (int v : iso.Reached)
+        iso.Dist.push_back(W.Dist[v]);
+
+    if (!withPolygon)
+        return;
+
+    std::vector<GeoPoint> points;
+    for (int u : iso.Reached)
+    {
+        points.push_back(GeoPoint{G.Lat[u], G.Lon[u]});
+
+        // where the budget runs out along each edge leaving the area
+        // (the edges are short enough to interpolate linearly)
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            if (W.Settled[v] || G.Weights[e] <= 0.0 || (closed && closed->blocks(e, v)))
+                continue;
+
+            double t = (radius - W.Dist[u]) / G.Weights[e];
+            if (t > 0.0 && t < 1.0)
+                points.push_back(GeoPoint{G.Lat[u] + t * (G.Lat[v] - G.Lat[u]),
+                                          G.Lon[u] + t * (G.Lon[v] - G.Lon[u])});
+        }
+    }
+    iso.Hull = convexHull(points);
+}
+
+//
+// convexHull
+//
+// Andrew's monotone chain.
+//
+std::vector<GeoPoint> convexHull(std::vector<GeoPoint> points)
+{
+    std::sort(points.begin(), points.end(), [](const GeoPoint &a, const GeoPoint &b) {
+        if (a.Lon != b.Lon)
+            return a.Lon < b.Lon;
+        return a.Lat < b.Lat;
+    });
+    points.erase(std::unique(points.begin(), points.end(), [](const GeoPoint &a, const GeoPoint &b) {
+                     return a.Lon == b.Lon && a.Lat == b.Lat;
+                 }),
+                 points.end());
+    if (points.size() < 3)
+        return points;
+
+    // > 0 if o -> a -> b turns counter-clockwise
+    auto cross = [](const GeoPoint &o, const GeoPoint &a, const GeoPoint &b) {
+        return (a.Lon - o.Lon) * (b.Lat - o.Lat) - (a.Lat - o.Lat) * (b.Lon - o.Lon);
+    };
+
+    std::vector<GeoPoint> hull(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); ++i) // lower hull
+    {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+            k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i > 0; --i) // upper hull
+    {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0)
+            k--;
+        hull[k++] = points[i - 1];
+    }
+
+    hull.resize(k - 1); // the last point repeats the first
+    return hull;
+}
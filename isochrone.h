@@ -0,0 +1,63 @@
+/*isochrone.h*/
+
+//
+// Isochrones: everything within a walking distance of a start.
+//
+// The reachable set comes from boundedSearch, so an isochrone costs
+// time in proportion to the area it covers.  The boundary polygon is
+// the convex hull of the reached vertices plus, on every edge that
+// leaves the area, the point where the budget runs out; that keeps the
+// outline from stopping short of the last footway node reached.  A
+// convex hull overstates areas with deep notches (the far side of a
+// fenced lot, say); the reached set is exact.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "compactgraph.h"
+#include "search.h"
+
+const double WALKING_MILES_PER_MINUTE = 3.0 / 60.0; // 3 mph
+
+struct GeoPoint
+{
+    double Lat;
+    double Lon;
+};
+
+struct Isochrone
+{
+    int Source;
+    double Radius;               // miles
+    std::vector<int> Reached;    // vertices within Radius, nearest first
+    std::vector<double> Dist;    // distance of each, in miles
+    std::vector<GeoPoint> Hull;  // boundary, counter-clockwise; empty unless requested
+
+    Isochrone()
+    {
+        Source = -1;
+        Radius = 0.0;
+    }
+};
+
+//
+// computeIsochrone
+//
+// Fills iso with the vertices within radius miles of source (using
+// the workspace W) and, if withPolygon, the boundary polygon.  With
+// closed, closed footways are neither walked nor part of the outline.
+//
+void computeIsochrone(const CompactGraph &G, int source, double radius,
+                      SearchWorkspace &W, Isochrone &iso, bool withPolygon,
+                      const Closures *closed = nullptr);
+
+//
+// convexHull
+//
+// Convex hull of points (longitude as x, latitude as y), counter-
+// clockwise, without repeating the first point.  Fewer than three
+// distinct points come back as they are.
+//
+std::vector<GeoPoint> convexHull(std::vector<GeoPoint> points);
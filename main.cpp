@@ -28,79 +28,22 @@
 #include <cassert>
 #include <limits>
 #include <sstream>
+#include <fstream>
+#include <chrono>
+#include <memory>
 
 #include "tinyxml2.h"
 #include "dist.h"
 #include "osm.h"
 #include "graph.h" // Graph implementation
-
-template <typename VertexT, typename WeightT>
-std::vector<VertexT> Dijkstra(
-    graph<VertexT, WeightT> &G,
-    VertexT startV,
-    std::map<VertexT, WeightT> &distances,
-    std::map<VertexT, VertexT> &pred)
-{
-    const WeightT INF = std::numeric_limits<WeightT>::max();
-
-    std::vector<VertexT> visited;
-    std::set<VertexT> visitedSet;
-
-    std::vector<VertexT> graphVertices = G.getVertices();
-    std::priority_queue<
-        std::pair<WeightT, VertexT>,
-        std::vector<std::pair<WeightT, VertexT>>,
-        std::greater<std::pair<WeightT, VertexT>>>
-        unvisitedQueue;
-
-    for (VertexT &vertex : graphVertices)
-    {
-        unvisitedQueue.push(std::make_pair(INF, vertex));
-        distances.emplace(vertex, INF);
-        pred.emplace(vertex, 0);
-    }
-
-    unvisitedQueue.push(std::make_pair(0, startV));
-    distances[startV] = 0;
-
-    std::pair<WeightT, VertexT> currentV;
-    WeightT edgeWeight, altPathDistance;
-
-    while (!unvisitedQueue.empty())
-    {
-        currentV = unvisitedQueue.top();
-        unvisitedQueue.pop();
-
-        if (currentV.first == INF)
-            break;
-        else if (visitedSet.count(currentV.second) > 0)
-            continue;
-        else
-        {
-            visited.push_back(currentV.second);
-            visitedSet.emplace(currentV.second);
-        }
-
-        std::set<VertexT> neighbors = G.neighbors(currentV.second);
-
-        for (VertexT neighbor : neighbors)
-        {
-            edgeWeight = 0.0;
-            G.getWeight(currentV.second, neighbor, edgeWeight);
-            altPathDistance = currentV.first + edgeWeight;
-
-            auto distancesIt = distances.find(neighbor);
-            if (altPathDistance < distancesIt->second)
-            {
-                unvisitedQueue.emplace(altPathDistance, neighbor);
-                distancesIt->second = altPathDistance;
-                edgeWeight = altPathDistance;
-                pred[neighbor] = currentV.second;
-            }
-        }
-    }
-    return visited;
-}
+#include "compactgraph.h"
+#include "matrix.h"
+#include "search.h"
+#include "sptcache.h"
+#include "campus.h"
+#include "batch.h"
+#include "server.h"
+#include "tour.h"
 
 void addNodes(std::map<long long, Coordinates> &Nodes, graph<long long, double> &G)
 {
@@ -124,83 +67,6 @@ void addEdges(std::vector<FootwayInfo> &Footways, std::map<long long, Coordinate
     }
 }
 
-void addBuildings(
-    std::vector<BuildingInfo> &Buildings,
-    std::map<std::string, BuildingInfo> &buildingsAbbreviation,
-    std::map<std::string, BuildingInfo> &buildingsFullname)
-{
-    for (BuildingInfo building : Buildings)
-    {
-        buildingsAbbreviation.emplace(building.Abbrev, building);
-        buildingsFullname.emplace(building.Fullname.substr(0, building.Fullname.find('(') - 1), building);
-    }
-}
-
-std::map<std::string, BuildingInfo>::iterator findBuilding(
-    std::map<std::string, BuildingInfo> &buildings,
-    std::string query)
-{
-    return buildings.find(query);
-}
-
-/**
- * Given a string and a char
- * splitStr returns an array of with strings seperated by c
- * Ex. "This is a text" -> ["This", "is", "a", "text"]
- */
-std::vector<std::string> splitStr(std::string x, char c)
-{
-    std::stringstream ss(x);
-    std::string item;
-    std::vector<std::string> splittedStrings;
-
-    while (std::getline(ss, item, c))
-        splittedStrings.push_back(item);
-    return splittedStrings;
-}
-
-bool setBuildingInfo(
-    std::map<std::string, BuildingInfo> &buildingsAbbreviation,
-    std::map<std::string, BuildingInfo> &buildingsFullname,
-    BuildingInfo &buildingInfo,
-    std::string query)
-{
-    auto iterAbbrev = findBuilding(buildingsAbbreviation, query);
-    if (iterAbbrev == buildingsAbbreviation.end())
-    { // Abbreviation was not found, so we'll search for Fullname
-        auto iterFname = findBuilding(buildingsFullname, query);
-        if (iterFname != buildingsFullname.end())
-        {
-            buildingInfo = iterFname->second;
-            return true;
-        }
-        else
-        {
-            // We will search for a partial match
-            std::vector<std::string> words = splitStr(query, ' ');
-
-            for (auto iter : buildingsFullname)
-            {
-                for (std::string w : words)
-                {
-                    std::vector<std::string> splitName = splitStr(iter.second.Fullname, ' ');
-                    for (std::string sn : splitName)
-                    {
-                        if (w == sn)
-                        {
-                            buildingInfo = iter.second;
-                            return true;
-                        }
-                    }
-                }
-            }
-            return false;
-        }
-    }
-    buildingInfo = iterAbbrev->second;
-    return true;
-}
-
 /**
  * nearestNode loops through all Nodes in a given FootwayInfo vector
  * and finds the closest node to c
@@ -245,86 +111,427 @@ void printNearestNode(Coordinates &coord)
 }
 
 /**
- * Given all visited nodes from start to destination
- * tracePath traces all paths from the destination to 
- * the starting node
+ * Computes the building-by-building distance matrix and writes it
+ * to matrixFile (see writeDistanceMatrix for the format)
+ */
+int runMatrix(
+    CampusMap &campus,
+    std::string matrixFile,
+    bool withPaths,
+    int numThreads)
+{
+    CompactGraph &CG = campus.Graph;
+
+    // a building that snapped to no footway keeps its place as -1
+    std::vector<int> endpoints;
+    int unsnapped = 0;
+    for (BuildingInfo &building : campus.Buildings)
+    {
+        int v = campus.BuildingVertex[building.Coords.ID];
+        if (v < 0)
+            unsnapped++;
+        endpoints.push_back(v);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DistanceMatrix M;
+    if (!campus.Labels.empty())
+        labelDistanceMatrix(campus.Labels, endpoints, M, withPaths);
+    else if (!campus.Hierarchy.empty() && !withPaths)
+        phastDistanceMatrix(campus.Hierarchy, endpoints, M, numThreads);
+    else
+        computeDistanceMatrix(CG, endpoints, M, withPaths, numThreads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!writeDistanceMatrix(matrixFile, CG, M))
+    {
+        std::cout << "**Error: unable to write '" << matrixFile << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Distance matrix: " << M.N << "x" << M.N << " in "
+              << elapsed.count() << " s, written to " << matrixFile << std::endl;
+    if (unsnapped > 0)
+        std::cout << unsnapped << " buildings are on no footway; their rows and columns are unreachable"
+                  << std::endl;
+    return 0;
+}
+
+/**
+ * Plans a tour of the comma-separated stops in tourStops and prints
+ * the visiting order, its length and the path
+ */
+int runTour(
+    CampusMap &campus,
+    std::string tourStops,
+    TourKind kind,
+    int numThreads)
+{
+    CompactGraph &CG = campus.Graph;
+
+    std::vector<std::string> names = splitStr(tourStops, ',');
+    std::vector<int> stops;
+    for (std::string &name : names)
+    {
+        int v = resolveLocation(campus, name);
+        if (v < 0)
+        {
+            std::cout << "Stop not found: " << name << std::endl;
+            return 1;
+        }
+        stops.push_back(v);
+    }
+
+    TourPlan plan;
+    if (!planTour(campus, stops, kind, numThreads, plan))
+    {
+        std::cout << "Sorry, some stops cannot reach each other" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Tour of " << stops.size() << " stops (" << (plan.Exact ? "exact" : "heuristic")
+              << " order; table " << plan.TableSeconds << " s, order " << plan.OrderSeconds
+              << " s):" << std::endl;
+    std::cout << " ";
+    for (size_t i = 0; i < plan.Order.size(); ++i)
+        std::cout << names[plan.Order[i]] << (i + 1 < plan.Order.size() ? " -> " : "");
+    if (kind == TOUR_ROUND_TRIP && !plan.Order.empty())
+        std::cout << " -> " << names[0];
+    std::cout << std::endl;
+
+    std::cout << "Distance: " << plan.Miles << " miles" << std::endl;
+    std::cout << "Path: ";
+    for (size_t i = 0; i < plan.Path.size(); ++i)
+        std::cout << CG.IDs[plan.Path[i]] << (i + 1 < plan.Path.size() ? "->" : "");
+    std::cout << std::endl;
+    return 0;
+}
+
+/**
+ * Reports the graph's components, its cells, overlay and arc flags, the
+ * hub labels, the contraction hierarchies, the ALT landmarks and, with
+ * --simplify, how much smaller the search graph got (on stderr, so it
+ * never mixes with the results)
  */
-std::stack<long long> tracePath(std::map<long long, long long> &pred, long long start, long long dest)
+void reportGraph(const CampusMap &campus)
 {
-    std::stack<long long> shortestPath;
-    // Return empty stack if
-    if (start == dest)
-        return shortestPath;
+    const CompactGraph &CG = campus.Graph;
+    if (!CG.ComponentSize.empty())
+        std::cerr << "components: " << CG.ComponentSize.size() << " (largest "
+                  << CG.ComponentSize[0] << " of " << CG.NumVertices() << " vertices)" << std::endl;
+
+    const Partition &P = campus.Cells;
+    for (int level = 0; level < P.NumLevels(); ++level)
+        std::cerr << "cells, level " << level << ": " << P.NumCells[level] << " of at most "
+                  << P.MaxCellSize[level] << " vertices, " << P.CutEdges[level] << " cut edges, "
+                  << P.BoundaryVertices[level] << " boundary vertices" << std::endl;
+    if (!P.empty() && P.BuildSeconds > 0)
+        std::cerr << "cells built in " << P.BuildSeconds << " s" << std::endl;
+    else if (!P.empty())
+        std::cerr << "cells read from file" << std::endl;
+
+    const CrpOverlay &O = campus.Overlay;
+    if (!O.empty())
+    {
+        size_t entries = 0;
+        for (const std::vector<double> &cliques : campus.OverlayMetric.Cliques)
+            entries += cliques.size();
+        std::cerr << "overlay: " << O.NumLevels() << " levels, " << entries << " clique entries ("
+                  << entries * sizeof(double) / (1 << 20) << " MB), customized in "
+                  << campus.OverlayMetric.CustomizeSeconds << " s" << std::endl;
+    }
+
+    const ArcFlags &F = campus.Flags;
+    if (!F.empty())
+        std::cerr << "arc flags: " << F.NumCells << " cells (level " << F.Level << "), "
+                  << F.NumPatterns() << " distinct flag vectors, " << F.bytes() / 1024
+                  << " KB, built in " << F.BuildSeconds << " s" << std::endl;
+
+    const HubLabels &H = campus.Labels;
+    if (!H.empty())
+        std::cerr << "hub labels: " << H.NumEntries() << " entries ("
+                  << (double)H.NumEntries() / CG.NumVertices() << " per vertex, "
+                  << H.bytes() / (1 << 20) << " MB) built in " << H.BuildSeconds << " s" << std::endl;
+
+    const ContractionHierarchy &CH = campus.Hierarchy;
+    if (!CH.empty())
+        std::cerr << "hierarchy: " << CH.NumShortcuts << " shortcuts, "
+                  << CH.UpTargets.size() << " upward edges, built in "
+                  << CH.BuildSeconds << " s" << std::endl;
+
+    const CchTopology &T = campus.Cch;
+    if (!T.empty())
+    {
+        std::cerr << "cch: " << T.NumArcs() << " upward arcs (" << T.NumFillIn << " fill-in), "
+                  << T.LevelOffsets.size() - 1 << " levels, built in " << T.BuildSeconds
+                  << " s; customized in";
+        for (size_t i = 0; i < campus.Metrics.size(); ++i)
+            std::cerr << (i > 0 ? ", " : " ") << campus.Metrics[i].CustomizeSeconds << " s ("
+                      << campus.Metrics[i].Name << ")";
+        std::cerr << std::endl;
+    }
 
-    long long end = pred.find(dest)->second;
-    shortestPath.push(dest);
+    if (!campus.Alt.empty())
+        std::cerr << "landmarks: " << campus.Alt.K() << " ("
+                  << campus.Alt.bytes() / (1 << 20) << " MB)" << std::endl;
 
-    while (end != 0)
+    const SimplifiedGraph &S = campus.Simplified;
+    if (S.empty())
+        return;
+
+    std::cerr << "simplified: " << campus.Graph.NumVertices() << " -> "
+              << S.Core.NumVertices() << " vertices, " << campus.Graph.NumEdges()
+              << " -> " << S.Core.NumEdges() << " edges" << std::endl;
+}
+
+/**
+ * Answers the start/destination pairs in batchFile ("-" for stdin)
+ * and writes one result line per query to stdout
+ */
+int runBatchFile(CampusMap &campus, std::string batchFile, const BatchOptions &options)
+{
+    if (batchFile == "-")
+        return runBatch(campus, std::cin, stdout, std::cerr, options);
+
+    std::ifstream input(batchFile.c_str());
+    if (!input)
     {
-        shortestPath.push(end);
-        end = pred.find(end)->second;
+        std::cerr << "**Error: unable to open '" << batchFile << "'." << std::endl;
+        return 1;
     }
-    return shortestPath;
+    return runBatch(campus, input, stdout, std::cerr, options);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    std::map<long long, Coordinates> Nodes; // maps a Node ID to it's coordinates (lat, lon)
-    std::vector<FootwayInfo> Footways;      // info about each footway, in no particular order
-    std::vector<BuildingInfo> Buildings;    // info about each building, in no particular order
-    tinyxml2::XMLDocument xmldoc;
+    CampusMap campus;
+    std::map<long long, Coordinates> &Nodes = campus.Nodes;
+    std::vector<FootwayInfo> &Footways = campus.Footways;
+    std::vector<BuildingInfo> &Buildings = campus.Buildings;
+
+    //
+    // Command line: program [--matrix file [--paths]] [--threads n]
+    //                       [--batch file|- [--no-paths]
+    //                        [--queue binary|dary|radix|dial]]
+    //                       [--quantize cm|mm] [--simplify]
+    //                       [--order osm|hilbert|bfs] [--snap-giant]
+    //                       [--alt n [--alt-select farthest|avoid]
+    //                        [--alt-mb n] [--alt-file file]]
+    //                       [--hub-labels] [--phast] [--cch]
+    //                       [--partition sizes [--partition-file file]]
+    //                       [--crp] [--arc-flags]
+    //                       [--server socket | --tcp port]
+    //                       [--tour stop,stop,... [--round-trip]]
+    //                       [--cache-mb n] [mapfile]
+    //
+    std::string filename;
+    std::string matrixFile;
+    std::string batchFile;
+    BatchOptions batchOptions;
+    LoadOptions loadOptions;
+    ServerOptions serverOptions;
+    bool matrixPaths = false;
+    std::string tourStops;
+    TourKind tourKind = TOUR_OPEN;
+    int numThreads = 0;
+    int cacheMB = 64;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--matrix" && i + 1 < argc)
+            matrixFile = argv[++i];
+        else if (arg == "--paths")
+            matrixPaths = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (arg == "--cache-mb" && i + 1 < argc)
+            cacheMB = atoi(argv[++i]);
+        else if (arg == "--batch" && i + 1 < argc)
+            batchFile = argv[++i];
+        else if (arg == "--no-paths")
+            batchOptions.WithPaths = false;
+        else if (arg == "--queue" && i + 1 < argc)
+        {
+            if (!parseQueueKind(argv[++i], batchOptions.Queue))
+            {
+                std::cerr << "**Error: unknown queue '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--quantize" && i + 1 < argc)
+        {
+            std::string unit = argv[++i];
+            if (unit == "cm")
+                loadOptions.QuantizeUnitsPerMile = CENTIMETERS_PER_MILE;
+            else if (unit == "mm")
+                loadOptions.QuantizeUnitsPerMile = MILLIMETERS_PER_MILE;
+            else
+            {
+                std::cerr << "**Error: unknown unit '" << unit << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--simplify")
+            loadOptions.Simplify = true;
+        else if (arg == "--alt" && i + 1 < argc)
+            loadOptions.NumLandmarks = atoi(argv[++i]);
+        else if (arg == "--alt-select" && i + 1 < argc)
+        {
+            if (!parseLandmarkStrategy(argv[++i], loadOptions.LandmarkSelect))
+            {
+                std::cerr << "**Error: unknown landmark strategy '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--alt-mb" && i + 1 < argc)
+            loadOptions.LandmarkBudgetBytes = (size_t)atoi(argv[++i]) << 20;
+        else if (arg == "--alt-file" && i + 1 < argc)
+            loadOptions.LandmarkFile = argv[++i];
+        else if (arg == "--phast")
+            loadOptions.UseHierarchy = true;
+        else if (arg == "--hub-labels")
+            loadOptions.UseHubLabels = true;
+        else if (arg == "--cch")
+            loadOptions.UseCch = true;
+        else if (arg == "--partition" && i + 1 < argc)
+        {
+            if (!parseCellSizes(argv[++i], loadOptions.CellSizes))
+            {
+                std::cerr << "**Error: bad cell sizes '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--partition-file" && i + 1 < argc)
+            loadOptions.PartitionFile = argv[++i];
+        else if (arg == "--crp")
+            loadOptions.UseCrp = true;
+        else if (arg == "--arc-flags")
+            loadOptions.UseArcFlags = true;
+        else if (arg == "--snap-giant")
+            loadOptions.SnapToGiant = true;
+        else if (arg == "--order" && i + 1 < argc)
+        {
+            if (!parseVertexOrder(argv[++i], loadOptions.Order))
+            {
+                std::cerr << "**Error: unknown vertex order '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--server" && i + 1 < argc)
+            serverOptions.SocketPath = argv[++i];
+        else if (arg == "--tcp" && i + 1 < argc)
+            serverOptions.TcpPort = atoi(argv[++i]);
+        else if (arg == "--tour" && i + 1 < argc)
+            tourStops = argv[++i];
+        else if (arg == "--round-trip")
+            tourKind = TOUR_ROUND_TRIP;
+        else
+            filename = arg;
+    }
+
+    std::string def_filename = "map.osm";
+
+    if ((int)loadOptions.Simplify + (loadOptions.NumLandmarks > 0) + (int)loadOptions.UseHubLabels +
+            (int)loadOptions.UseCch + (int)loadOptions.UseCrp + (int)loadOptions.UseArcFlags > 1)
+    {
+        std::cerr << "**Error: use only one of --simplify, --alt, --hub-labels, --cch, --crp and "
+                     "--arc-flags."
+                  << std::endl;
+        return 1;
+    }
+
+    // the overlay and the flags need cells; three levels unless
+    // --partition says otherwise
+    if ((loadOptions.UseCrp || loadOptions.UseArcFlags) && loadOptions.CellSizes.empty())
+        parseCellSizes("256,2048,16384", loadOptions.CellSizes);
+
+    // parent pointers for path recovery are only kept if some output
+    // needs paths; the server always does
+    if (matrixFile != "")
+        loadOptions.HubLabelPaths = matrixPaths;
+    else if (batchFile != "")
+        loadOptions.HubLabelPaths = batchOptions.WithPaths;
+
+    // Batch and server modes keep stdout machine-readable: no banner,
+    // no prompts
+    bool server = serverOptions.SocketPath != "" || serverOptions.TcpPort > 0;
+    if (batchFile != "" || server)
+    {
+        if (filename == "")
+            filename = def_filename;
+        if (!loadCampusMap(filename, campus, loadOptions))
+        {
+            std::cerr << "**Error: unable to load open street map." << std::endl;
+            return 1;
+        }
+        reportGraph(campus);
+
+        if (server)
+        {
+            MapSnapshot maps(filename, loadOptions, std::make_shared<CampusMap>(std::move(campus)));
+            serverOptions.Threads = numThreads;
+            return runServer(maps, serverOptions);
+        }
+
+        batchOptions.Threads = numThreads;
+        return runBatchFile(campus, batchFile, batchOptions);
+    }
 
     std::cout << "** Navigating UIC open street map **" << std::endl;
     std::cout << endl;
     std::cout << std::setprecision(8);
 
-    std::string def_filename = "map.osm";
-    std::string filename;
-
-    std::cout << "Enter map filename> ";
-    getline(std::cin, filename);
+    if (filename == "")
+    {
+        std::cout << "Enter map filename> ";
+        getline(std::cin, filename);
+    }
 
     if (filename == "")
         filename = def_filename;
 
     // Load XML-based map file
-    if (!LoadOpenStreetMap(filename, xmldoc))
+    if (!loadCampusMap(filename, campus, loadOptions))
     {
         cout << "**Error: unable to load open street map." << endl;
         cout << endl;
         return 0;
     }
 
-    // Read the nodes, which are the various known positions on the map:
-    size_t nodeCount = ReadMapNodes(xmldoc, Nodes);
-
-    // Read the footways, which are the walking paths:
-    size_t footwayCount = ReadFootways(xmldoc, Footways);
-
-    // Read the university buildings:
-    size_t buildingCount = ReadUniversityBuildings(xmldoc, Nodes, Buildings);
-
-    // Stats
-    assert(nodeCount == Nodes.size());
-    assert(footwayCount == Footways.size());
-    assert(buildingCount == Buildings.size());
-
     std::cout << std::endl;
     std::cout << "# of nodes: " << Nodes.size() << std::endl;
     std::cout << "# of footways: " << Footways.size() << std::endl;
     std::cout << "# of buildings: " << Buildings.size() << std::endl;
 
+    if (matrixFile != "")
+    {
+        reportGraph(campus);
+        return runMatrix(campus, matrixFile, matrixPaths, numThreads);
+    }
+
+    if (tourStops != "")
+    {
+        reportGraph(campus);
+        return runTour(campus, tourStops, tourKind, numThreads);
+    }
+
     graph<long long, double> G;
     addNodes(Nodes, G); // Add all nodes to graph
     addEdges(Footways, Nodes, G);
 
-    std::map<std::string, BuildingInfo> buildingsAbbreviation, buildingsFullname;
-    addBuildings(Buildings, buildingsAbbreviation, buildingsFullname);
-
     std::cout << "# of vertices: " << G.NumVertices() << std::endl;
     std::cout << "# of edges: " << G.NumEdges() << std::endl;
     std::cout << std::endl;
 
+    // Routing runs on the compact graph.  The search from the last
+    // start is kept and resumed when only the destination changes;
+    // once it has grown into the whole tree, the tree is cached, so a
+    // start seen before skips the search entirely
+    CompactGraph &CG = campus.Graph;
+    SearchWorkspace workspace;
+    SptCache treeCache((size_t)cacheMB << 20);
+
     // Navigation from building to building
     std::string startBuilding, destBuilding;
 
@@ -338,8 +545,8 @@ int main()
         std::cout << "Enter destination (partial name or abbreviation)> ";
         std::getline(cin, destBuilding);
 
-        bool startFound = setBuildingInfo(buildingsAbbreviation, buildingsFullname, startBuildingInfo, startBuilding);
-        bool destFound = setBuildingInfo(buildingsAbbreviation, buildingsFullname, destBuildingInfo, destBuilding);
+        bool startFound = setBuildingInfo(campus.BuildingsAbbreviation, campus.BuildingsFullname, startBuildingInfo, startBuilding);
+        bool destFound = setBuildingInfo(campus.BuildingsAbbreviation, campus.BuildingsFullname, destBuildingInfo, destBuilding);
 
         if (!startFound)
             std::cout << "Start building not found" << std::endl;
@@ -368,31 +575,48 @@ int main()
             // Dijksra's algorithm...
             std::cout << "Navigating with Dijkstra..." << std::endl;
 
-            std::map<long long, double> distances;
-            std::map<long long, long long> pred;
-            std::vector<long long> nodes = Dijkstra<long long, double>(G, startCoord.ID, distances, pred);
+            int startV = CG.vertexOf(startCoord.ID);
+            int destV = CG.vertexOf(destCoord.ID);
+            std::vector<int> shortestPath;
 
-            auto shortestPath = tracePath(pred, startCoord.ID, destCoord.ID);
+            // a start and destination in different components can
+            // skip the search: there is no path
+            if (startV >= 0 && destV >= 0 && CG.sameComponent(startV, destV))
+            {
+                auto tree = workspace.Source == startV ? nullptr : treeCache.find(startV);
+                if (tree)
+                    shortestPath = traceCompactPath(tree->Pred, startV, destV);
+                else
+                {
+                    // Same start as last time: pick the search up where it stopped
+                    bool complete = searchComplete(workspace) && workspace.Source == startV;
+                    if (workspace.Source != startV)
+                        startSearch(CG, startV, workspace);
+                    resumeSearch(CG, destV, workspace);
+                    if (!complete && searchComplete(workspace))
+                        treeCache.insert(makeTree(startV, workspace));
+                    shortestPath = traceCompactPath(workspace.Pred, startV, destV);
+                }
+            }
 
-            if (shortestPath.empty())
+            if (startCoord.ID == destCoord.ID)
             {
                 std::cout << "Distance to dest: 0 miles" << std::endl;
                 std::cout << "Path: " << startCoord.ID << std::endl;
             }
-            else if (shortestPath.top() == destCoord.ID)
+            else if (shortestPath.empty())
                 std::cout << "Sorry, destination unreachable" << std::endl;
             else
             {
-                std::cout << "Distance to dest: " << distances.find(destCoord.ID)->second << " miles" << std::endl;
+                std::cout << "Distance to dest: " << pathLength(CG, shortestPath) << " miles" << std::endl;
 
                 std::cout << "Path: ";
                 // Print all nodes from start to dest
-                while (!shortestPath.empty())
+                for (size_t i = 0; i < shortestPath.size(); ++i)
                 {
-                    std::cout << shortestPath.top();
-                    if (shortestPath.top() != destCoord.ID)
+                    std::cout << CG.IDs[shortestPath[i]];
+                    if (i + 1 < shortestPath.size())
                         std::cout << "->";
-                    shortestPath.pop();
                 }
                 std::cout << std::endl;
             }
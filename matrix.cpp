@@ -0,0 +1,224 @@
+/*matrix.cpp*/
+
+//
+// Many-to-many distance matrix between a set of endpoints.
+//
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "search.h"
+#include "matrix.h"
+#include "phast.h"
+#include "threadpool.h" // defaultThreadCount
+
+//
+// computeDistanceMatrix
+//
+void computeDistanceMatrix(const CompactGraph &G,
+                           const std::vector<int> &vertices,
+                           DistanceMatrix &M,
+                           bool withPaths,
+                           int numThreads,
+                           const Closures *closed)
+{
+    M.N = (int)vertices.size();
+    M.Vertices = vertices;
+    M.Dist.assign((size_t)M.N * M.N, INF_DIST);
+    M.Paths.clear();
+    if (withPaths)
+        M.Paths.resize((size_t)M.N * M.N);
+
+    // searches stop at the endpoints that have a vertex
+    std::vector<int> targets;
+    for (int v : vertices)
+        if (v >= 0)
+            targets.push_back(v);
+
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    if (numThreads > M.N)
+        numThreads = M.N;
+
+    //
+    // rows are handed out one at a time; each thread writes only the
+    // rows it claimed, so no further locking is needed:
+    //
+    std::atomic<int> nextRow(0);
+
+    auto worker = [&]() {
+        SearchWorkspace W;
+        W.init(G.NumVertices());
+
+        int i;
+        while ((i = nextRow.fetch_add(1)) < M.N)
+        {
+            if (vertices[i] < 0)
+                continue;
+            dijkstraSearch(G, vertices[i], W, targets, QUEUE_DARY, closed);
+
+            for (int j = 0; j < M.N; ++j)
+            {
+                int t = vertices[j];
+                if (t < 0 || !W.Settled[t])
+                    continue;
+                M.Dist[(size_t)i * M.N + j] = W.Dist[t];
+                if (withPaths)
+                    M.Paths[(size_t)i * M.N + j] = traceCompactPath(W.Pred, vertices[i], t);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; ++t)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (std::thread &t : threads)
+        t.join();
+}
+
+//
+// labelDistanceMatrix
+//
+void labelDistanceMatrix(const HubLabels &H,
+                         const std::vector<int> &vertices,
+                         DistanceMatrix &M,
+                         bool withPaths)
+{
+    M.N = (int)vertices.size();
+    M.Vertices = vertices;
+    M.Dist.assign((size_t)M.N * M.N, INF_DIST);
+    M.Paths.clear();
+    if (withPaths)
+        M.Paths.resize((size_t)M.N * M.N);
+
+    for (int i = 0; i < M.N; ++i)
+    {
+        for (int j = 0; j < M.N; ++j)
+        {
+            if (vertices[i] < 0 || vertices[j] < 0)
+                continue;
+            M.Dist[(size_t)i * M.N + j] = hubDistance(H, vertices[i], vertices[j]);
+            if (withPaths)
+                M.Paths[(size_t)i * M.N + j] = hubPath(H, vertices[i], vertices[j]);
+        }
+    }
+}
+
+//
+// phastDistanceMatrix
+//
+void phastDistanceMatrix(const ContractionHierarchy &CH,
+                         const std::vector<int> &vertices,
+                         DistanceMatrix &M,
+                         int numThreads)
+{
+    M.N = (int)vertices.size();
+    M.Vertices = vertices;
+    M.Dist.assign((size_t)M.N * M.N, INF_DIST);
+    M.Paths.clear();
+
+    // only the endpoints with a vertex get a sweep
+    std::vector<int> rows;
+    for (int i = 0; i < M.N; ++i)
+        if (vertices[i] >= 0)
+            rows.push_back(i);
+
+    int numRows = (int)rows.size();
+    int numGroups = (numRows + PHAST_LANES - 1) / PHAST_LANES;
+    if (numThreads <= 0)
+        numThreads = defaultThreadCount();
+    if (numThreads > numGroups)
+        numThreads = numGroups;
+
+    // groups of PHAST_LANES rows are handed out like single rows above
+    std::atomic<int> nextGroup(0);
+
+    auto worker = [&]() {
+        PhastWorkspace P;
+        std::vector<int> sources;
+
+        int g;
+        while ((g = nextGroup.fetch_add(1)) < numGroups)
+        {
+            int first = g * PHAST_LANES;
+            int last = std::min(numRows, first + PHAST_LANES);
+            sources.clear();
+            for (int r = first; r < last; ++r)
+                sources.push_back(vertices[rows[r]]);
+            phastSearch(CH, sources, P);
+
+            for (int r = first; r < last; ++r)
+                for (int j = 0; j < M.N; ++j)
+                    if (vertices[j] >= 0)
+                        M.Dist[(size_t)rows[r] * M.N + j] = phastDistance(CH, P, r - first, vertices[j]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; ++t)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (std::thread &t : threads)
+        t.join();
+}
+
+//
+// writeDistanceMatrix
+//
+bool writeDistanceMatrix(const std::string &filename,
+                         const CompactGraph &G,
+                         const DistanceMatrix &M)
+{
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    auto put = [&out](const void *data, size_t size) {
+        out.write(static_cast<const char *>(data), size);
+    };
+
+    uint32_t header[3] = {1, (uint32_t)M.N, M.Paths.empty() ? 0u : 1u};
+    put("CMDM", 4);
+    put(header, sizeof(header));
+
+    std::vector<int64_t> ids;
+    for (int v : M.Vertices)
+        ids.push_back(v >= 0 ? G.IDs[v] : -1);
+    put(ids.data(), ids.size() * sizeof(int64_t));
+
+    std::vector<float> row(M.N);
+    for (int i = 0; i < M.N; ++i)
+    {
+        for (int j = 0; j < M.N; ++j)
+        {
+            double d = M.at(i, j);
+            row[j] = (d == INF_DIST) ? std::numeric_limits<float>::infinity() : (float)d;
+        }
+        put(row.data(), row.size() * sizeof(float));
+    }
+
+    if (!M.Paths.empty())
+    {
+        uint32_t numVertices = (uint32_t)G.NumVertices();
+        put(&numVertices, sizeof(numVertices));
+        std::vector<int64_t> table(G.IDs.begin(), G.IDs.end());
+        put(table.data(), table.size() * sizeof(int64_t));
+
+        for (const std::vector<int> &path : M.Paths)
+        {
+            uint32_t length = (uint32_t)path.size();
+            put(&length, sizeof(length));
+            std::vector<uint32_t> packed(path.begin(), path.end());
+            put(packed.data(), packed.size() * sizeof(uint32_t));
+        }
+    }
+
+    return (bool)out;
+}
@@ -0,0 +1,100 @@
+/*matrix.h*/
+
+//
+// Many-to-many distance matrix between a set of endpoints (usually the
+// snapped nodes of every building).
+//
+// Each row is one Dijkstra search from an endpoint; the search stops
+// once every endpoint is settled instead of growing the whole tree,
+// and rows are computed in parallel, one workspace per thread.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+#include "closures.h"
+#include "hublabels.h"
+#include "ch.h"
+
+struct DistanceMatrix
+{
+    int N;                               // number of endpoints
+    std::vector<int> Vertices;           // dense vertex of each endpoint, -1 if none
+    std::vector<double> Dist;            // N*N, row-major, miles; INF_DIST if unreachable
+    std::vector<std::vector<int>> Paths; // N*N dense vertex paths, if requested
+
+    DistanceMatrix()
+    {
+        N = 0;
+    }
+
+    double at(int i, int j) const
+    {
+        return this->Dist[(size_t)i * this->N + j];
+    }
+};
+
+//
+// computeDistanceMatrix
+//
+// Fills M with the distance (and, if withPaths, the path) between
+// every pair of vertices.  numThreads <= 0 means one thread per core.
+// A vertex of -1 (a building that snapped to no footway) gets an
+// unreachable row and column, here and in the builders below.
+// With closed, the searches avoid the closed edges and vertices.
+//
+void computeDistanceMatrix(const CompactGraph &G,
+                           const std::vector<int> &vertices,
+                           DistanceMatrix &M,
+                           bool withPaths,
+                           int numThreads,
+                           const Closures *closed = nullptr);
+
+//
+// labelDistanceMatrix
+//
+// The same from hub labels, with one label merge per entry instead of
+// one search per row.  withPaths needs labels built with paths.
+//
+void labelDistanceMatrix(const HubLabels &H,
+                         const std::vector<int> &vertices,
+                         DistanceMatrix &M,
+                         bool withPaths);
+
+//
+// phastDistanceMatrix
+//
+// The same from a contraction hierarchy (distances only): rows are
+// computed PHAST_LANES at a time by one-to-all sweeps, in parallel.
+//
+void phastDistanceMatrix(const ContractionHierarchy &CH,
+                         const std::vector<int> &vertices,
+                         DistanceMatrix &M,
+                         int numThreads);
+
+//
+// writeDistanceMatrix
+//
+// Writes M to filename in host byte order:
+//
+//   char[4]  "CMDM"
+//   uint32   version (1)
+//   uint32   N
+//   uint32   flags (bit 0: paths present)
+//   int64    OSM node id of each endpoint, -1 if none (N)
+//   float32  distance in miles, +inf if unreachable  (N*N, row-major)
+//
+// and, if paths are present:
+//
+//   uint32   V, then int64 OSM node id of each vertex (V)
+//   per pair (row-major): uint32 length, then length uint32 vertex
+//   numbers indexing the table above
+//
+// Returns false if the file cannot be written.
+//
+bool writeDistanceMatrix(const std::string &filename,
+                         const CompactGraph &G,
+                         const DistanceMatrix &M);
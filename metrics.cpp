@@ -0,0 +1,89 @@
+/*metrics.cpp*/
+
+//
+// Named weightings of the footway graph.
+//
+
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+
+//
+// weightingNames
+//
+std::vector<std::string> weightingNames()
+{
+    return std::vector<std::string>{"shortest", "avoid-stairs", "prefer-covered"};
+}
+
+//
+// weightingRules
+//
+bool weightingRules(const std::string &name, std::vector<WeightRule> &rules)
+{
+    rules.clear();
+    if (name == "shortest")
+        return true;
+    if (name == "avoid-stairs")
+    {
+        rules.push_back(WeightRule{"step_count=", 4.0});
+        rules.push_back(WeightRule{"incline=", 2.0});
+        rules.push_back(WeightRule{"wheelchair=no", 2.0});
+        return true;
+    }
+    if (name == "prefer-covered")
+    {
+        rules.push_back(WeightRule{"covered=yes", 0.75});
+        rules.push_back(WeightRule{"indoor=yes", 0.75});
+        rules.push_back(WeightRule{"tunnel=yes", 0.75});
+        return true;
+    }
+    return false;
+}
+
+static bool tagMatches(const std::string &tag, const std::string &rule)
+{
+    if (!rule.empty() && rule[rule.size() - 1] == '=')
+        return tag.compare(0, rule.size(), rule) == 0;
+    return tag == rule;
+}
+
+static double footwayFactor(const FootwayInfo &footway, const std::vector<WeightRule> &rules)
+{
+    for (const WeightRule &rule : rules)
+        for (const std::string &tag : footway.Tags)
+            if (tagMatches(tag, rule.Tag))
+                return rule.Factor;
+    return 1.0;
+}
+
+//
+// footwayWeights
+//
+void footwayWeights(const CompactGraph &G, const std::vector<FootwayInfo> &Footways,
+                    const std::vector<WeightRule> &rules, std::vector<double> &weights)
+{
+    weights = G.Weights;
+    if (rules.empty())
+        return;
+
+    for (const FootwayInfo &footway : Footways)
+    {
+        double factor = footwayFactor(footway, rules);
+        for (size_t i = 0; i + 1 < footway.Nodes.size(); ++i)
+        {
+            int u = G.vertexOf(footway.Nodes[i]);
+            int v = G.vertexOf(footway.Nodes[i + 1]);
+            if (u < 0 || v < 0)
+                continue;
+
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (G.Targets[e] == v)
+                    weights[e] = G.Weights[e] * factor;
+            for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+                if (G.Targets[e] == u)
+                    weights[e] = G.Weights[e] * factor;
+        }
+    }
+}
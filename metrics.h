@@ -0,0 +1,56 @@
+/*metrics.h*/
+
+//
+// Named weightings of the footway graph.
+//
+// A weighting scales the length of each footway by a factor chosen
+// from its OSM tags, so that, say, covered walkways count for less
+// when it rains.  Every weighting keeps the footway graph's topology,
+// which is what lets one customizable contraction hierarchy (cch.h)
+// serve all of them.  The factor of a footway is that of the first
+// rule its tags match (1 if none):
+//
+//   shortest        length alone
+//   avoid-stairs    footways with steps or a steep incline count
+//                   several times over
+//   prefer-covered  covered, indoor and tunnel footways count for less
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+#include "osm.h"
+
+struct WeightRule
+{
+    std::string Tag; // "key=value", or "key=" for any value
+    double Factor;
+};
+
+//
+// weightingNames
+//
+// The built-in weightings, "shortest" first.
+//
+std::vector<std::string> weightingNames();
+
+//
+// weightingRules
+//
+// The rules of a built-in weighting; returns false for an unknown name.
+//
+bool weightingRules(const std::string &name, std::vector<WeightRule> &rules);
+
+//
+// footwayWeights
+//
+// One weight per edge of G: its length times the factor of the footway
+// it lies on.  Like the graph, an edge that several footways share
+// takes the last one's.  Both directions of an edge get the same
+// weight.
+//
+void footwayWeights(const CompactGraph &G, const std::vector<FootwayInfo> &Footways,
+                    const std::vector<WeightRule> &rules, std::vector<double> &weights);
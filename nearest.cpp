@@ -0,0 +1,93 @@
+/*nearest.cpp*/
+
+//
+// "Nearest building of a kind" queries.
+//
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+
+#include "nearest.h"
+
+static std::string lowercase(std::string s)
+{
+    for (char &c : s)
+        c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+//
+// buildingMatches
+//
+bool buildingMatches(const BuildingInfo &building, const std::string &category)
+{
+    size_t equals = category.find('=');
+    if (equals != std::string::npos)
+    {
+        for (const std::string &tag : building.Tags)
+        {
+            if (equals + 1 == category.size() ? tag.compare(0, equals + 1, category) == 0
+                                              : tag == category)
+                return true;
+        }
+        return false;
+    }
+
+    return lowercase(building.Fullname).find(lowercase(category)) != std::string::npos;
+}
+
+//
+// nearestBuilding
+//
+void nearestBuilding(const CampusMap &campus, int origin, const std::string &category,
+                     SearchWorkspace &W, NearestResult &r, const Closures *closed)
+{
+    r = NearestResult();
+    const CompactGraph &G = campus.Graph;
+
+    if (closed && closed->vertexClosed(origin))
+        return;
+
+    // every reachable match is a seed; several may share a vertex
+    std::vector<SearchSeed> seeds;
+    std::vector<int> candidates; // building of each seed
+    for (size_t i = 0; i < campus.Buildings.size(); ++i)
+    {
+        const BuildingInfo &building = campus.Buildings[i];
+        if (!buildingMatches(building, category))
+            continue;
+
+        auto snapped = campus.BuildingVertex.find(building.Coords.ID);
+        if (snapped == campus.BuildingVertex.end() || snapped->second < 0 ||
+            !G.sameComponent(origin, snapped->second) ||
+            (closed && closed->vertexClosed(snapped->second)))
+            continue;
+
+        seeds.push_back(SearchSeed(snapped->second, 0.0));
+        candidates.push_back((int)i);
+    }
+    r.Candidates = (int)seeds.size();
+    if (seeds.empty())
+        return;
+
+    dijkstraSearch(G, seeds, W, std::vector<int>(1, origin), QUEUE_DARY, closed);
+    r.Settled = W.NumSettled;
+    if (!W.Settled[origin])
+        return;
+
+    // Pred points from the origin back to the seed it was reached from
+    for (int v = origin; v != -1; v = W.Pred[v])
+        r.Path.push_back(v);
+    r.Miles = W.Dist[origin];
+
+    for (size_t i = 0; i < seeds.size(); ++i)
+    {
+        if (seeds[i].Vertex == r.Path.back())
+        {
+            r.Building = candidates[i];
+            break;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*nearest.h*/
+
+//
+// "Nearest building of a kind" queries.
+//
+// Rather than one search per candidate building, the search is run
+// backwards from all of them at once: every candidate's snapped vertex
+// is a seed, and the search stops as soon as the origin is settled.
+// Whichever seed the origin's tree path leads to is the closest
+// candidate (the footway graph is symmetric), and that tree path,
+// read from the origin, is the route to it.  One search, however many
+// candidates there are.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "campus.h"
+#include "search.h"
+
+struct NearestResult
+{
+    int Building;          // index into campus.Buildings, -1 if none reachable
+    double Miles;
+    std::vector<int> Path; // dense vertices, origin to the building
+    int Candidates;        // matching buildings that were searched from
+    long long Settled;     // vertices the search settled
+
+    NearestResult()
+    {
+        Building = -1;
+        Miles = 0.0;
+        Candidates = 0;
+        Settled = 0;
+    }
+};
+
+//
+// buildingMatches
+//
+// "key=value" matches a building with that tag, "key=" any value of
+// the key; anything else matches if it occurs in the full name,
+// ignoring case (so "hall" finds every hall).
+//
+bool buildingMatches(const BuildingInfo &building, const std::string &category);
+
+//
+// nearestBuilding
+//
+// The building matching category that is closest to vertex origin by
+// footway, with the route to it, using the workspace W.  With closed,
+// closed footways (and buildings on closed nodes) are avoided.
+//
+void nearestBuilding(const CampusMap &campus, int origin, const std::string &category,
+                     SearchWorkspace &W, NearestResult &r, const Closures *closed = nullptr);
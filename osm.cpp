@@ -140,6 +140,7 @@ int ReadFootways(XMLDocument &xmldoc, vector<FootwayInfo> &Footways)
         // see if this is a footway:
         //
         bool isFootway = false;
+        vector<string> tags; // everything but the highway tag
 
         XMLElement *tag = way->FirstChildElement("tag");
         while (tag != nullptr)
@@ -154,10 +155,12 @@ int ReadFootways(XMLDocument &xmldoc, vector<FootwayInfo> &Footways)
 
                 if ((strcmp(k_value, "highway") == 0) && (strcmp(v_value, "footway") == 0))
                 {
-                    footwayCount++;
+                    if (!isFootway) // a repeated tag still makes one footway
+                        footwayCount++;
                     isFootway = true;
-                    break;
                 }
+                else if (strcmp(k_value, "highway") != 0)
+                    tags.push_back(string(k_value) + "=" + v_value);
             }
 
             tag = tag->NextSiblingElement("tag");
@@ -186,6 +189,7 @@ int ReadFootways(XMLDocument &xmldoc, vector<FootwayInfo> &Footways)
                 nd = nd->NextSiblingElement("nd");
             }
 
+            footway.Tags = tags;
             Footways.push_back(footway);
         } //if
 
@@ -225,6 +229,7 @@ int ReadUniversityBuildings(XMLDocument &xmldoc,
         bool isBuilding = false;
 
         const char *buildingName = nullptr;
+        vector<string> tags;
 
         XMLElement *tag = way->FirstChildElement("tag");
         while (tag != nullptr)
@@ -247,6 +252,10 @@ int ReadUniversityBuildings(XMLDocument &xmldoc,
                 {
                     buildingName = v_value;
                 }
+                else if (strcmp(k_value, "building") != 0)
+                {
+                    tags.push_back(string(k_value) + "=" + v_value);
+                }
             }
 
             tag = tag->NextSiblingElement("tag");
@@ -310,6 +319,7 @@ int ReadUniversityBuildings(XMLDocument &xmldoc,
             }
 
             Buildings.push_back(BuildingInfo(fullname, abbrev, id, lat, lon));
+            Buildings.back().Tags = tags;
         } //if
 
         way = way->NextSiblingElement("way");
@@ -54,12 +54,14 @@ struct Coordinates
 //
 // Example: think of a footway as a sidewalk, with points n1, n2, ...,
 // nx, ny.  n1 and ny denote the endpoints of the sidewalk, and the points
-// n2, ..., nx are intermediate points along the sidewalk.
+// n2, ..., nx are intermediate points along the sidewalk.  Tags keeps
+// the footway's other OSM tags as "key=value" (e.g. "covered=yes").
 //
 struct FootwayInfo
 {
     long long ID;
     vector<long long> Nodes;
+    vector<string> Tags;
 
     FootwayInfo()
     {
@@ -76,13 +78,15 @@ struct FootwayInfo
 // BuildingInfo
 //
 // Defines a campus building with a fullname, an abbreviation (e.g. SEO),
-// and the coordinates of the building (id, lat, lon).
+// and the coordinates of the building (id, lat, lon).  Tags keeps the
+// building's other OSM tags as "key=value" (e.g. "amenity=library").
 //
 struct BuildingInfo
 {
     string Fullname;
     string Abbrev;
     Coordinates Coords;
+    vector<string> Tags;
 
     BuildingInfo()
     {
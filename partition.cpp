@@ -0,0 +1,526 @@
+/*partition.cpp*/
+
+//
+// Balanced multi-level partition by recursive inertial-flow bisection.
+//
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include "partition.h"
+
+// fraction of a cell fixed to each side before the flow runs
+static const double FIXED_FRACTION = 0.25;
+
+namespace
+{
+enum Role
+{
+    FREE,
+    SOURCE,
+    SINK
+};
+
+//
+// Bisector
+//
+// Scratch for bisecting cells of one graph: a stamp marks the vertices
+// of the cell being cut, so no state needs clearing between cells.
+//
+struct Bisector
+{
+    const CompactGraph &G;
+    std::vector<int> Reverse;    // edge u->v -> edge v->u
+    std::vector<double> X, Y;    // planar coordinates
+    std::vector<int> InCell;     // == cell while v is in the cell being cut
+    std::vector<int> Seen;       // == visit once a search has reached v
+    std::vector<int> Level;      // distance from the sources, if Seen
+    std::vector<int> NextEdge;   // next edge of v to try this phase
+    std::vector<signed char> Roles;
+    std::vector<signed char> Flow; // per edge, -1 .. 1
+    std::vector<int> Queue;
+    int cell;
+    int visit;
+
+    Bisector(const CompactGraph &graph);
+
+    void fixSides(const std::vector<int> &vertices, double dx, double dy);
+    bool levelGraph(const std::vector<int> &vertices);
+    int blockingFlow(const std::vector<int> &vertices);
+    void reachFromSinks(const std::vector<int> &vertices);
+    int cut(const std::vector<int> &vertices, double dx, double dy,
+            std::vector<int> &left, std::vector<int> &right);
+    int bisect(const std::vector<int> &vertices, std::vector<int> &left, std::vector<int> &right);
+};
+
+Bisector::Bisector(const CompactGraph &graph) : G(graph)
+{
+    int n = G.NumVertices();
+    Reverse.assign(G.NumEdges(), -1);
+    for (int u = 0; u < n; ++u)
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            for (int r = G.Offsets[v]; r < G.Offsets[v + 1]; ++r)
+                if (G.Targets[r] == u)
+                {
+                    Reverse[e] = r;
+                    break;
+                }
+        }
+
+    // longitude shrinks toward the poles; scale it like latitude
+    const double PI = 3.14159265;
+    double meanLat = 0.0;
+    for (int v = 0; v < n; ++v)
+        meanLat += G.Lat[v];
+    meanLat = n > 0 ? meanLat / n : 0.0;
+    double shrink = std::cos(meanLat * PI / 180.0);
+    X.resize(n);
+    Y.resize(n);
+    for (int v = 0; v < n; ++v)
+    {
+        X[v] = G.Lon[v] * shrink;
+        Y[v] = G.Lat[v];
+    }
+
+    InCell.assign(n, 0);
+    Seen.assign(n, 0);
+    Level.assign(n, 0);
+    NextEdge.assign(n, 0);
+    Roles.assign(n, FREE);
+    Flow.assign(G.NumEdges(), 0);
+    cell = 0;
+    visit = 0;
+}
+
+//
+// fixSides
+//
+// Sorts the cell along (dx, dy) and fixes its first and last quarter
+// as the sources and sinks; clears the flow inside the cell.
+//
+void Bisector::fixSides(const std::vector<int> &vertices, double dx, double dy)
+{
+    std::vector<std::pair<double, int>> order;
+    order.reserve(vertices.size());
+    for (int v : vertices)
+        order.push_back(std::make_pair(dx * X[v] + dy * Y[v], v));
+    std::sort(order.begin(), order.end());
+
+    size_t fixed = std::max((size_t)1, (size_t)(FIXED_FRACTION * vertices.size()));
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int v = order[i].second;
+        Roles[v] = i < fixed ? SOURCE : (i >= order.size() - fixed ? SINK : FREE);
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            Flow[e] = 0;
+    }
+}
+
+//
+// levelGraph
+//
+// One breadth-first search from all sources through edges with
+// capacity left, giving each vertex reached its distance.  Returns
+// false, leaving Seen == visit on the source side of a minimum cut,
+// once no sink can be reached.
+//
+bool Bisector::levelGraph(const std::vector<int> &vertices)
+{
+    ++visit;
+    Queue.clear();
+    for (int v : vertices)
+        if (Roles[v] == SOURCE)
+        {
+            Seen[v] = visit;
+            Level[v] = 0;
+            NextEdge[v] = G.Offsets[v];
+            Queue.push_back(v);
+        }
+
+    bool reached = false;
+    for (size_t head = 0; head < Queue.size(); ++head)
+    {
+        int u = Queue[head];
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            if (InCell[v] != cell || Seen[v] == visit || Flow[e] >= 1)
+                continue;
+            Seen[v] = visit;
+            Level[v] = Level[u] + 1;
+            NextEdge[v] = G.Offsets[v];
+            if (Roles[v] == SINK)
+                reached = true; // the sinks act as one, so never leave one
+            else
+                Queue.push_back(v);
+        }
+    }
+    return reached;
+}
+
+//
+// blockingFlow
+//
+// Pushes units from the sources to the sinks along edges one level
+// apart until every such path is saturated (Dinic).  Each vertex
+// resumes scanning its edges where it stopped, and one that leads
+// nowhere is dropped from the level graph.  Returns the units pushed.
+//
+int Bisector::blockingFlow(const std::vector<int> &vertices)
+{
+    int pushed = 0;
+    std::vector<int> &path = Queue; // edges from the source so far
+    for (int s : vertices)
+    {
+        if (Roles[s] != SOURCE)
+            continue;
+
+        path.clear();
+        int u = s;
+        while (true)
+        {
+            if (Roles[u] == SINK)
+            {
+                for (int e : path)
+                {
+                    Flow[e]++;
+                    Flow[Reverse[e]]--;
+                }
+                pushed++;
+                path.clear();
+                u = s;
+                continue;
+            }
+
+            int &e = NextEdge[u];
+            for (; e < G.Offsets[u + 1]; ++e)
+            {
+                int v = G.Targets[e];
+                if (InCell[v] == cell && Seen[v] == visit && Level[v] == Level[u] + 1 && Flow[e] < 1)
+                    break;
+            }
+            if (e < G.Offsets[u + 1])
+            {
+                path.push_back(e);
+                u = G.Targets[e];
+                continue;
+            }
+
+            // a dead end: retreat, and never come back here this phase
+            Level[u] = -1;
+            if (path.empty())
+                break;
+            u = G.Targets[Reverse[path.back()]];
+            path.pop_back();
+            NextEdge[u]++;
+        }
+    }
+    return pushed;
+}
+
+//
+// reachFromSinks
+//
+// Marks (Seen == visit) the vertices that can still push flow into a
+// sink: the sink side of the minimum cut closest to the sinks.
+//
+void Bisector::reachFromSinks(const std::vector<int> &vertices)
+{
+    ++visit;
+    Queue.clear();
+    for (int v : vertices)
+        if (Roles[v] == SINK)
+        {
+            Seen[v] = visit;
+            Queue.push_back(v);
+        }
+
+    for (size_t head = 0; head < Queue.size(); ++head)
+    {
+        int v = Queue[head];
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+        {
+            int u = G.Targets[e];
+            if (InCell[u] != cell || Seen[u] == visit || Flow[Reverse[e]] >= 1)
+                continue;
+            Seen[u] = visit;
+            Queue.push_back(u);
+        }
+    }
+}
+
+//
+// cut
+//
+// Inertial flow along (dx, dy): the minimum cut between the fixed
+// quarters, next to the sources or next to the sinks, whichever is
+// better balanced.  Returns its size in edges.
+//
+int Bisector::cut(const std::vector<int> &vertices, double dx, double dy,
+                  std::vector<int> &left, std::vector<int> &right)
+{
+    fixSides(vertices, dx, dy);
+    int flow = 0;
+    while (levelGraph(vertices))
+        flow += blockingFlow(vertices);
+
+    std::vector<char> sourceSide(vertices.size());
+    size_t sourceCount = 0;
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        sourceSide[i] = Seen[vertices[i]] == visit;
+        sourceCount += sourceSide[i];
+    }
+
+    reachFromSinks(vertices);
+    size_t sinkCount = 0;
+    for (int v : vertices)
+        sinkCount += Seen[v] == visit;
+
+    // vertices cut off from both sides go with the smaller one
+    size_t n = vertices.size();
+    bool nearSinks = std::min(n - sinkCount, sinkCount) > std::min(sourceCount, n - sourceCount);
+
+    left.clear();
+    right.clear();
+    for (size_t i = 0; i < n; ++i)
+    {
+        int v = vertices[i];
+        bool onLeft = nearSinks ? Seen[v] != visit : sourceSide[i];
+        (onLeft ? left : right).push_back(v);
+    }
+    return flow;
+}
+
+//
+// bisect
+//
+// Tries four directions and keeps the smallest cut, the better
+// balanced of equal ones.
+//
+int Bisector::bisect(const std::vector<int> &vertices, std::vector<int> &left, std::vector<int> &right)
+{
+    static const double DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+    ++cell;
+    for (int v : vertices)
+        InCell[v] = cell;
+
+    int best = -1;
+    std::vector<int> l, r;
+    for (const double *d : DIRECTIONS)
+    {
+        int size = this->cut(vertices, d[0], d[1], l, r);
+        size_t balance = std::min(l.size(), r.size());
+        if (best < 0 || size < best ||
+            (size == best && balance > std::min(left.size(), right.size())))
+        {
+            best = size;
+            left.swap(l);
+            right.swap(r);
+        }
+    }
+    return best;
+}
+
+//
+// splitCell
+//
+// Bisects vertices until every piece has at most maxSize of them,
+// appending the pieces depth first.
+//
+void splitCell(Bisector &B, const std::vector<int> &vertices, int maxSize,
+               std::vector<std::vector<int>> &cells)
+{
+    if ((int)vertices.size() <= maxSize)
+    {
+        cells.push_back(vertices);
+        return;
+    }
+
+    std::vector<int> left, right;
+    B.bisect(vertices, left, right);
+    splitCell(B, left, maxSize, cells);
+    splitCell(B, right, maxSize, cells);
+}
+}
+
+//
+// countCuts
+//
+// Fills the per-level statistics of P from its cells.
+//
+static void countCuts(const CompactGraph &G, Partition &P)
+{
+    int n = G.NumVertices();
+    P.NumCells.assign(P.NumLevels(), 0);
+    P.CutEdges.assign(P.NumLevels(), 0);
+    P.BoundaryVertices.assign(P.NumLevels(), 0);
+
+    for (int level = 0; level < P.NumLevels(); ++level)
+    {
+        const std::vector<int> &cells = P.Cells[level];
+        for (int u = 0; u < n; ++u)
+        {
+            P.NumCells[level] = std::max(P.NumCells[level], cells[u] + 1);
+            bool boundary = false;
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+            {
+                int v = G.Targets[e];
+                if (cells[u] == cells[v])
+                    continue;
+                boundary = true;
+                if (u < v)
+                    P.CutEdges[level]++;
+            }
+            P.BoundaryVertices[level] += boundary;
+        }
+    }
+}
+
+//
+// parseCellSizes
+//
+bool parseCellSizes(const std::string &text, std::vector<int> &sizes)
+{
+    sizes.clear();
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (item.empty() || item.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        int size = std::atoi(item.c_str());
+        if (size < 2 || (!sizes.empty() && size <= sizes.back()))
+            return false;
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+//
+// buildPartition
+//
+void buildPartition(const CompactGraph &G, const std::vector<int> &maxCellSize, Partition &P)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int n = G.NumVertices();
+    P = Partition();
+    P.MaxCellSize = maxCellSize;
+    P.Cells.assign(maxCellSize.size(), std::vector<int>(n, 0));
+
+    // coarsest level first, each splitting the cells of the one above
+    Bisector B(G);
+    std::vector<std::vector<int>> cells(1);
+    for (int v = 0; v < n; ++v)
+        cells[0].push_back(v);
+
+    for (int level = P.NumLevels() - 1; level >= 0; --level)
+    {
+        std::vector<std::vector<int>> finer;
+        for (const std::vector<int> &cell : cells)
+            splitCell(B, cell, maxCellSize[level], finer);
+
+        for (size_t c = 0; c < finer.size(); ++c)
+            for (int v : finer[c])
+                P.Cells[level][v] = (int)c;
+        cells.swap(finer);
+    }
+
+    countCuts(G, P);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    P.BuildSeconds = elapsed.count();
+}
+
+//
+// writePartition
+//
+bool writePartition(const std::string &filename, const CompactGraph &G, const Partition &P)
+{
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out)
+        return false;
+
+    auto put = [&out](const void *data, size_t size) {
+        out.write(static_cast<const char *>(data), size);
+    };
+
+    uint32_t header[3] = {1, (uint32_t)G.NumVertices(), (uint32_t)P.NumLevels()};
+    uint64_t fingerprint = graphFingerprint(G);
+    put("CMPT", 4);
+    put(header, sizeof(header));
+    put(&fingerprint, sizeof(fingerprint));
+
+    std::vector<int32_t> sizes(P.MaxCellSize.begin(), P.MaxCellSize.end());
+    put(sizes.data(), sizes.size() * sizeof(int32_t));
+    for (const std::vector<int> &cells : P.Cells)
+    {
+        std::vector<int32_t> ids(cells.begin(), cells.end());
+        put(ids.data(), ids.size() * sizeof(int32_t));
+    }
+
+    return (bool)out;
+}
+
+//
+// readPartition
+//
+bool readPartition(const std::string &filename, const CompactGraph &G, Partition &P)
+{
+    P = Partition();
+
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+
+    auto get = [&in](void *data, size_t size) {
+        in.read(static_cast<char *>(data), size);
+        return (bool)in;
+    };
+
+    char magic[4];
+    uint32_t header[3];
+    uint64_t fingerprint;
+    if (!get(magic, 4) || std::memcmp(magic, "CMPT", 4) != 0 ||
+        !get(header, sizeof(header)) || !get(&fingerprint, sizeof(fingerprint)))
+        return false;
+    if (header[0] != 1 || header[1] != (uint32_t)G.NumVertices() ||
+        fingerprint != graphFingerprint(G))
+        return false;
+
+    int n = G.NumVertices();
+    int levels = (int)header[2];
+    std::vector<int32_t> sizes(levels);
+    if (!get(sizes.data(), sizes.size() * sizeof(int32_t)))
+        return false;
+
+    Partition loaded;
+    loaded.MaxCellSize.assign(sizes.begin(), sizes.end());
+    for (int level = 0; level < levels; ++level)
+    {
+        std::vector<int32_t> ids(n);
+        if (!get(ids.data(), ids.size() * sizeof(int32_t)))
+            return false;
+        for (int32_t id : ids)
+            if (id < 0 || id >= n)
+                return false;
+        loaded.Cells.push_back(std::vector<int>(ids.begin(), ids.end()));
+    }
+
+    countCuts(G, loaded);
+    P = std::move(loaded);
+    return true;
+}
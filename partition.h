@@ -0,0 +1,85 @@
+/*partition.h*/
+
+//
+// Balanced multi-level partition of the footway graph into cells.
+//
+// Every level splits the vertices into cells of at most a given size,
+// each cell nested in one cell of the next (coarser) level.  The cells
+// come from recursive bisection by inertial flow: for a few directions
+// across the map, sort the cell's vertices along the direction, fix
+// the first quarter to one side and the last quarter to the other, and
+// let a unit-capacity max flow between them move the border in the
+// middle half to the fewest edges.  The direction with the smallest
+// cut wins.  Of the minimum cuts the flow finds (the one next to the
+// sources and the one next to the sinks) the better balanced is kept.
+//
+// A cut is counted in edges (each two-way footway segment once).  The
+// boundary vertices of a level -- those with an edge into another cell
+// -- are what any speedup built on the cells pays for.
+//
+// Cell ids are assigned depth first, so the cells of one coarser cell
+// are numbered consecutively.
+//
+// Schild and Sommer, "On Balanced Separators in Road Networks" (SEA
+// 2015).
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+
+struct Partition
+{
+    std::vector<int> MaxCellSize;          // per level, finest (level 0) first
+    std::vector<std::vector<int>> Cells;   // Cells[level][v]: the cell of v
+    std::vector<int> NumCells;             // per level
+    std::vector<int> CutEdges;             // per level: edges between two cells
+    std::vector<int> BoundaryVertices;     // per level
+    double BuildSeconds;
+
+    Partition()
+    {
+        BuildSeconds = 0.0;
+    }
+
+    bool empty() const
+    {
+        return this->Cells.empty();
+    }
+
+    int NumLevels() const
+    {
+        return (int)this->Cells.size();
+    }
+};
+
+//
+// parseCellSizes
+//
+// Parses a comma-separated list of increasing cell sizes, finest
+// first (e.g. "256,4096,65536").  Returns false if it is malformed.
+//
+bool parseCellSizes(const std::string &text, std::vector<int> &sizes);
+
+//
+// buildPartition
+//
+// Partitions G into one level per entry of maxCellSize (finest first,
+// increasing, each at least 2).
+//
+void buildPartition(const CompactGraph &G, const std::vector<int> &maxCellSize, Partition &P);
+
+//
+// writePartition, readPartition
+//
+// Binary file: "CMPT", uint32 version (1), uint32 N, uint32 levels,
+// uint64 fingerprint of the graph, the levels' int32 maximum cell
+// sizes, then levels*N int32 cell ids.  readPartition returns false
+// (and leaves P empty) if the file is missing, malformed, or was built
+// for a different graph.
+//
+bool writePartition(const std::string &filename, const CompactGraph &G, const Partition &P);
+bool readPartition(const std::string &filename, const CompactGraph &G, Partition &P);
@@ -0,0 +1,77 @@
+/*phast.cpp*/
+
+//
+// PHAST: one-to-all distances from a contraction hierarchy.
+//
+
+#include <vector>
+#include <algorithm>
+
+#include "phast.h"
+#include "search.h" // INF_DIST
+
+//
+// upwardSearch
+//
+// Dijkstra from rank source over upward edges, into lane i.
+//
+static void upwardSearch(const ContractionHierarchy &CH, int source, int i, PhastWorkspace &P)
+{
+    const int K = P.K;
+    IndexedDaryHeap<4> &queue = P.Queue;
+
+    queue.clear();
+    P.Dist[(size_t)source * K + i] = 0.0;
+    queue.update(source, 0.0);
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+        int u = current.second;
+
+        for (int e = CH.UpOffsets[u]; e < CH.UpOffsets[u + 1]; ++e)
+        {
+            double &d = P.Dist[(size_t)CH.UpTargets[e] * K + i];
+            double alt = current.first + CH.UpWeights[e];
+            if (alt < d)
+            {
+                d = alt;
+                queue.update(CH.UpTargets[e], alt);
+            }
+        }
+    }
+}
+
+//
+// phastSearch
+//
+void phastSearch(const ContractionHierarchy &CH, const std::vector<int> &sources,
+                 PhastWorkspace &P)
+{
+    int n = CH.NumVertices();
+    const int K = (int)sources.size();
+
+    P.K = K;
+    P.Dist.assign((size_t)n * K, INF_DIST);
+    P.Queue.init(n);
+
+    for (int i = 0; i < K; ++i)
+        upwardSearch(CH, CH.Rank[sources[i]], i, P);
+
+    //
+    // downward sweep, highest rank first.  INF_DIST + w rounds back to
+    // INF_DIST, so unreached lanes need no test.
+    //
+    double *dist = P.Dist.data();
+    for (int r = n - 1; r >= 0; --r)
+    {
+        double *dr = dist + (size_t)r * K;
+        for (int e = CH.UpOffsets[r]; e < CH.UpOffsets[r + 1]; ++e)
+        {
+            const double *du = dist + (size_t)CH.UpTargets[e] * K;
+            double w = CH.UpWeights[e];
+            for (int i = 0; i < K; ++i)
+                dr[i] = std::min(dr[i], du[i] + w);
+        }
+    }
+}
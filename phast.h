@@ -0,0 +1,67 @@
+/*phast.h*/
+
+//
+// PHAST: one-to-all distances from a contraction hierarchy.
+//
+// Dijkstra computes one-to-all distances by popping every vertex off
+// a priority queue, in an order that jumps all over memory.  With a
+// contraction hierarchy (ch.h) the same distances take two phases:
+//
+//   1. a Dijkstra search from the source over upward edges only,
+//      which settles just a few hundred vertices, and
+//   2. one sweep over all vertices from the highest rank down,
+//      setting d(v) = min(d(v), d(u) + w) over v's upward edges
+//      (v, u, w).  Every u has a higher rank, so its distance is
+//      final by the time v is reached.
+//
+// The sweep has no queue at all: it walks the rank-ordered upward
+// graph front to back, so it is a linear array scan.  Running several
+// sources at once (PhastWorkspace::K "lanes") stores their distances
+// side by side, Dist[r*K + i], so the sweep does K independent
+// min/add operations per edge, which the compiler can vectorize, and
+// loads every edge once for all K sources.
+//
+// Only distances are computed; the upward edges of the sweep include
+// shortcuts, so predecessors would have to be unpacked.  Use
+// dijkstraSearch when the tree itself is needed.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "ch.h"
+#include "pqueue.h"
+
+const int PHAST_LANES = 8; // sources per sweep used by the matrix code
+
+struct PhastWorkspace
+{
+    int K;                    // number of sources of the last sweep
+    std::vector<double> Dist; // in rank space: Dist[r*K + i], INF_DIST if unreachable
+    IndexedDaryHeap<4> Queue;
+
+    PhastWorkspace()
+    {
+        K = 0;
+    }
+};
+
+//
+// phastSearch
+//
+// Distances from each of sources (at most a handful; see PHAST_LANES)
+// to every vertex.
+//
+void phastSearch(const ContractionHierarchy &CH, const std::vector<int> &sources,
+                 PhastWorkspace &P);
+
+//
+// phastDistance
+//
+// Distance from sources[i] of the last phastSearch to vertex v.
+//
+inline double phastDistance(const ContractionHierarchy &CH, const PhastWorkspace &P, int i, int v)
+{
+    return P.Dist[(size_t)CH.Rank[v] * P.K + i];
+}
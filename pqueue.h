@@ -0,0 +1,308 @@
+/*pqueue.h*/
+
+//
+// Priority queues for Dijkstra-style searches over dense vertex ids.
+//
+// All three share one interface, so a search can be written once as
+// a template over the queue:
+//
+//   init(n)         size for vertices 0..n-1
+//   clear()         empty the queue (cost proportional to its contents)
+//   empty()
+//   update(v, key)  insert v, or lower its key if already queued
+//   pop()           remove and return the (key, vertex) with least key
+//
+// LazyBinaryHeap    std::priority_queue; update always pushes, so pop
+//                   can return stale entries the caller must skip.
+// IndexedDaryHeap   D-ary heap with a position index; update is a real
+//                   decrease-key, so every vertex is queued at most once
+//                   and pop never returns a stale entry.  It also takes
+//                   other key types (D* Lite's two-part keys), and keys
+//                   that go up (set) or away (remove).
+// RadixHeap         monotone integer-bucket queue for non-negative
+//                   keys; every key pushed must be >= the last key
+//                   popped (true in Dijkstra).  Lazy, like the binary
+//                   heap.
+//
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+class LazyBinaryHeap
+{
+private:
+    std::priority_queue<
+        std::pair<double, int>,
+        std::vector<std::pair<double, int>>,
+        std::greater<std::pair<double, int>>>
+        heap;
+
+public:
+    void init(int n)
+    {
+        this->clear();
+    }
+
+    void clear()
+    {
+        while (!this->heap.empty())
+            this->heap.pop();
+    }
+
+    bool empty() const
+    {
+        return this->heap.empty();
+    }
+
+    void update(int v, double key)
+    {
+        this->heap.push(std::make_pair(key, v));
+    }
+
+    std::pair<double, int> pop()
+    {
+        std::pair<double, int> top = this->heap.top();
+        this->heap.pop();
+        return top;
+    }
+};
+
+template <int D, typename Key = double>
+class IndexedDaryHeap
+{
+private:
+    typedef std::pair<Key, int> Entry;
+
+    std::vector<Entry> heap;
+    std::vector<int> pos; // index of v in heap, or -1
+
+    void place(int i, const Entry &entry)
+    {
+        this->heap[i] = entry;
+        this->pos[entry.second] = i;
+    }
+
+    void siftUp(int i)
+    {
+        Entry entry = this->heap[i];
+        while (i > 0)
+        {
+            int parent = (i - 1) / D;
+            if (!(entry < this->heap[parent]))
+                break;
+            this->place(i, this->heap[parent]);
+            i = parent;
+        }
+        this->place(i, entry);
+    }
+
+    void siftDown(int i)
+    {
+        Entry entry = this->heap[i];
+        int n = (int)this->heap.size();
+        while (true)
+        {
+            int first = i * D + 1;
+            if (first >= n)
+                break;
+
+            int last = (first + D < n) ? first + D : n;
+            int best = first;
+            for (int c = first + 1; c < last; ++c)
+                if (this->heap[c] < this->heap[best])
+                    best = c;
+
+            if (!(this->heap[best] < entry))
+                break;
+            this->place(i, this->heap[best]);
+            i = best;
+        }
+        this->place(i, entry);
+    }
+
+    void removeAt(int i)
+    {
+        this->pos[this->heap[i].second] = -1;
+
+        Entry last = this->heap.back();
+        this->heap.pop_back();
+        if (i < (int)this->heap.size())
+        {
+            this->place(i, last);
+            this->siftUp(i);
+            this->siftDown(this->pos[last.second]);
+        }
+    }
+
+public:
+    void init(int n)
+    {
+        this->heap.clear();
+        this->pos.assign(n, -1);
+    }
+
+    void clear()
+    {
+        for (const Entry &entry : this->heap)
+            this->pos[entry.second] = -1;
+        this->heap.clear();
+    }
+
+    bool empty() const
+    {
+        return this->heap.empty();
+    }
+
+    bool contains(int v) const
+    {
+        return this->pos[v] >= 0;
+    }
+
+    void update(int v, Key key)
+    {
+        int i = this->pos[v];
+        if (i < 0)
+        {
+            this->heap.push_back(std::make_pair(key, v));
+            this->siftUp((int)this->heap.size() - 1);
+        }
+        else if (key < this->heap[i].first)
+        {
+            this->heap[i].first = key;
+            this->siftUp(i);
+        }
+    }
+
+    //
+    // set
+    //
+    // Like update, but the key may also go up.
+    //
+    void set(int v, Key key)
+    {
+        int i = this->pos[v];
+        if (i >= 0 && this->heap[i].first < key)
+        {
+            this->heap[i].first = key;
+            this->siftDown(i);
+        }
+        else
+            this->update(v, key);
+    }
+
+    void remove(int v)
+    {
+        if (this->pos[v] >= 0)
+            this->removeAt(this->pos[v]);
+    }
+
+    const Entry &top() const
+    {
+        return this->heap[0];
+    }
+
+    Entry pop()
+    {
+        Entry top = this->heap[0];
+        this->removeAt(0);
+        return top;
+    }
+};
+
+class RadixHeap
+{
+private:
+    // a non-negative double's bit pattern orders the same way as its
+    // value, so the keys can be bucketed as 64-bit integers
+    std::vector<std::pair<uint64_t, int>> buckets[65];
+    uint64_t last; // key of the last pop
+    size_t count;
+
+    static uint64_t bits(double key)
+    {
+        uint64_t k;
+        std::memcpy(&k, &key, sizeof(k));
+        return k;
+    }
+
+    static double value(uint64_t k)
+    {
+        double key;
+        std::memcpy(&key, &k, sizeof(key));
+        return key;
+    }
+
+    // bucket i holds keys whose highest bit differing from last is i-1
+    static int bucketOf(uint64_t k, uint64_t last)
+    {
+        return k == last ? 0 : 64 - __builtin_clzll(k ^ last);
+    }
+
+public:
+    RadixHeap()
+    {
+        last = 0;
+        count = 0;
+    }
+
+    void init(int n)
+    {
+        this->clear();
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < 65; ++i)
+            this->buckets[i].clear();
+        this->last = 0;
+        this->count = 0;
+    }
+
+    bool empty() const
+    {
+        return this->count == 0;
+    }
+
+    void update(int v, double key)
+    {
+        uint64_t k = bits(key);
+        this->buckets[bucketOf(k, this->last)].push_back(std::make_pair(k, v));
+        this->count++;
+    }
+
+    std::pair<double, int> pop()
+    {
+        if (this->buckets[0].empty())
+        {
+            //
+            // refill bucket 0 from the first non-empty bucket: its
+            // minimum becomes the new last key, and every entry in it
+            // moves to a strictly lower bucket
+            //
+            int i = 1;
+            while (this->buckets[i].empty())
+                ++i;
+
+            uint64_t minKey = this->buckets[i][0].first;
+            for (const std::pair<uint64_t, int> &entry : this->buckets[i])
+                if (entry.first < minKey)
+                    minKey = entry.first;
+
+            this->last = minKey;
+            for (const std::pair<uint64_t, int> &entry : this->buckets[i])
+                this->buckets[bucketOf(entry.first, this->last)].push_back(entry);
+            this->buckets[i].clear();
+        }
+
+        std::pair<uint64_t, int> entry = this->buckets[0].back();
+        this->buckets[0].pop_back();
+        this->count--;
+        return std::make_pair(value(entry.first), entry.second);
+    }
+};
@@ -0,0 +1,209 @@
+/*reorder.cpp*/
+
+//
+// Cache-friendly vertex numbering for the compact graph.
+//
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "reorder.h"
+
+//
+// parseVertexOrder
+//
+bool parseVertexOrder(const std::string &name, VertexOrder &order)
+{
+    if (name == "osm")
+        order = ORDER_OSM;
+    else if (name == "hilbert")
+        order = ORDER_HILBERT;
+    else if (name == "bfs")
+        order = ORDER_BFS;
+    else
+        return false;
+    return true;
+}
+
+//
+// hilbertKey
+//
+// Distance of cell (x, y) along the Hilbert curve that fills a
+// 2^16 x 2^16 grid.
+//
+static uint64_t hilbertKey(uint32_t x, uint32_t y)
+{
+    const uint32_t side = 1u << 16;
+    uint64_t d = 0;
+
+    for (uint32_t s = side / 2; s > 0; s /= 2)
+    {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant so the curve stays continuous
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+//
+// hilbertOrder
+//
+std::vector<int> hilbertOrder(const CompactGraph &G)
+{
+    int n = G.NumVertices();
+    std::vector<int> order(n);
+    if (n == 0)
+        return order;
+
+    double minLat = *std::min_element(G.Lat.begin(), G.Lat.end());
+    double maxLat = *std::max_element(G.Lat.begin(), G.Lat.end());
+    double minLon = *std::min_element(G.Lon.begin(), G.Lon.end());
+    double maxLon = *std::max_element(G.Lon.begin(), G.Lon.end());
+    double latScale = (maxLat > minLat) ? 65535.0 / (maxLat - minLat) : 0.0;
+    double lonScale = (maxLon > minLon) ? 65535.0 / (maxLon - minLon) : 0.0;
+
+    std::vector<uint64_t> key(n);
+    for (int v = 0; v < n; ++v)
+    {
+        order[v] = v;
+        key[v] = hilbertKey((uint32_t)((G.Lon[v] - minLon) * lonScale),
+                            (uint32_t)((G.Lat[v] - minLat) * latScale));
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&key](int a, int b) {
+        return key[a] < key[b];
+    });
+    return order;
+}
+
+//
+// bfsOrder
+//
+std::vector<int> bfsOrder(const CompactGraph &G)
+{
+    int n = G.NumVertices();
+    auto degree = [&G](int v) { return G.Offsets[v + 1] - G.Offsets[v]; };
+
+    // start each component from a vertex of least degree (a dead end,
+    // usually), which keeps the breadth-first levels narrow
+    std::vector<int> starts(n);
+    for (int v = 0; v < n; ++v)
+        starts[v] = v;
+    std::stable_sort(starts.begin(), starts.end(), [&degree](int a, int b) {
+        return degree(a) < degree(b);
+    });
+
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> seen(n, 0);
+    std::vector<int> neighbors;
+
+    for (int s : starts)
+    {
+        if (seen[s])
+            continue;
+
+        seen[s] = 1;
+        size_t head = order.size();
+        order.push_back(s);
+
+        while (head < order.size())
+        {
+            int u = order[head++];
+
+            neighbors.clear();
+            for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+                if (!seen[G.Targets[e]])
+                {
+                    seen[G.Targets[e]] = 1;
+                    neighbors.push_back(G.Targets[e]);
+                }
+
+            std::stable_sort(neighbors.begin(), neighbors.end(), [&degree](int a, int b) {
+                return degree(a) < degree(b);
+            });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+//
+// permuteGraph
+//
+void permuteGraph(CompactGraph &G, const std::vector<int> &order)
+{
+    int n = G.NumVertices();
+    std::vector<int> rank(n);
+    for (int i = 0; i < n; ++i)
+        rank[order[i]] = i;
+
+    CompactGraph P;
+    P.IDs.resize(n);
+    P.Lat.resize(n);
+    P.Lon.resize(n);
+    P.Offsets.assign(n + 1, 0);
+    P.Targets.reserve(G.Targets.size());
+    P.Weights.reserve(G.Weights.size());
+    P.UnitsPerMile = G.UnitsPerMile;
+    P.MaxIntWeight = G.MaxIntWeight;
+    P.MinStretch = G.MinStretch;
+
+    std::vector<std::pair<int, int>> edges; // (new head, old edge)
+    for (int i = 0; i < n; ++i)
+    {
+        int v = order[i];
+        P.IDs[i] = G.IDs[v];
+        P.Lat[i] = G.Lat[v];
+        P.Lon[i] = G.Lon[v];
+        P.Index.emplace(G.IDs[v], i);
+
+        edges.clear();
+        for (int e = G.Offsets[v]; e < G.Offsets[v + 1]; ++e)
+            edges.push_back(std::make_pair(rank[G.Targets[e]], e));
+        std::sort(edges.begin(), edges.end());
+
+        for (auto &edge : edges)
+        {
+            P.Targets.push_back(edge.first);
+            P.Weights.push_back(G.Weights[edge.second]);
+            if (!G.IntWeights.empty())
+                P.IntWeights.push_back(G.IntWeights[edge.second]);
+        }
+        P.Offsets[i + 1] = (int)P.Targets.size();
+    }
+
+    G = std::move(P);
+}
+
+//
+// reorderGraph
+//
+void reorderGraph(CompactGraph &G, VertexOrder order)
+{
+    switch (order)
+    {
+    case ORDER_OSM:
+        break;
+    case ORDER_HILBERT:
+        permuteGraph(G, hilbertOrder(G));
+        break;
+    case ORDER_BFS:
+        permuteGraph(G, bfsOrder(G));
+        break;
+    }
+}
@@ -0,0 +1,71 @@
+/*reorder.h*/
+
+//
+// Cache-friendly vertex numbering for the compact graph.
+//
+// buildCompactGraph numbers vertices in increasing OSM id order,
+// which has little to do with where they are: two nodes a few feet
+// apart can be thousands of vertices apart, so a search touches a new
+// cache line (of Dist, Offsets, Targets, Lat/Lon...) for nearly every
+// vertex it settles.  Renumbering so that vertices that are close on
+// the map are close in the arrays makes searches and snapping much
+// kinder to the cache:
+//
+//   ORDER_HILBERT   sort by position along a Hilbert curve over
+//                   (lat, lon) -- nearby points get nearby keys
+//   ORDER_BFS       reverse Cuthill-McKee: breadth-first from a
+//                   low-degree vertex, visiting neighbors by
+//                   increasing degree, then reversed -- edges mostly
+//                   join vertices with nearby numbers
+//
+// Reordering only changes the numbering, never the graph; but ties
+// (equal-length paths, equidistant nodes) can come out differently,
+// so the default stays in OSM id order.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "compactgraph.h"
+
+enum VertexOrder
+{
+    ORDER_OSM,
+    ORDER_HILBERT,
+    ORDER_BFS
+};
+
+//
+// parseVertexOrder
+//
+// "osm", "hilbert" or "bfs"; returns false for anything else.
+//
+bool parseVertexOrder(const std::string &name, VertexOrder &order);
+
+//
+// hilbertOrder, bfsOrder
+//
+// Return the new numbering as a list of old vertices: order[i] is the
+// vertex that becomes vertex i.
+//
+std::vector<int> hilbertOrder(const CompactGraph &G);
+std::vector<int> bfsOrder(const CompactGraph &G);
+
+//
+// permuteGraph
+//
+// Renumbers G so that old vertex order[i] becomes vertex i, keeping
+// every edge list sorted by head.  Must run before the graph is
+// quantized or simplified and before anything stores vertex numbers.
+//
+void permuteGraph(CompactGraph &G, const std::vector<int> &order);
+
+//
+// reorderGraph
+//
+// permuteGraph(G, hilbertOrder(G)) or (G, bfsOrder(G)); ORDER_OSM
+// leaves G alone.
+//
+void reorderGraph(CompactGraph &G, VertexOrder order);
@@ -0,0 +1,227 @@
+/*router.cpp*/
+
+//
+// One point-to-point route query.
+//
+
+#include <chrono>
+
+#include "router.h"
+#include "sptcache.h"
+
+//
+// labelRoute
+//
+// Answers r from the hub labels.  With closures, the label route only
+// counts if it avoids them; returns false if it does not, so that a
+// search takes over.
+//
+static bool labelRoute(const CampusMap &campus, const RouteQuery &q, const Closures *closed,
+                       RouteResult &r)
+{
+    const HubLabels &H = campus.Labels;
+    r.Miles = hubDistance(H, r.Start, r.Dest);
+    if (r.Miles == INF_DIST)
+    {
+        r.Status = ROUTE_UNREACHABLE;
+        r.Miles = 0.0;
+        return true;
+    }
+
+    if ((q.WithPath || closed) && !H.Parents.empty())
+        r.Path = hubPath(H, r.Start, r.Dest);
+    if (closed && !pathOpen(campus.Graph, *closed, r.Path))
+        return false;
+
+    r.Status = ROUTE_OK;
+    if (!q.WithPath)
+        r.Path.clear();
+    return true;
+}
+
+//
+// findMetric
+//
+// The customized weighting q asks for, repaired for closed if given,
+// or nullptr if there is none: no CCH was built, or no weighting by
+// that name.
+//
+static const CchMetric *findMetric(const CampusMap &campus, const RouteQuery &q,
+                                   const Closures *closed)
+{
+    if (campus.Metrics.empty())
+        return nullptr;
+    const std::vector<CchMetric> &metrics = closed ? closed->Repaired->Metrics : campus.Metrics;
+    if (q.Metric == "")
+        return &metrics[0];
+    for (const CchMetric &M : metrics)
+        if (M.Name == q.Metric)
+            return &M;
+    return nullptr;
+}
+
+//
+// metricRoute
+//
+// Answers r under the weighting M from the CCH.
+//
+static void metricRoute(const CampusMap &campus, const CchMetric &M, SearchWorkspace &W,
+                        RouteResult &r)
+{
+    double cost;
+    bool found = cchRoute(campus.Cch, M, r.Start, r.Dest, W, r.Path, cost);
+    r.Settled = W.NumSettled;
+
+    if (found)
+    {
+        r.Status = ROUTE_OK;
+        r.Miles = pathLength(campus.Graph, r.Path);
+    }
+    else
+        r.Status = ROUTE_UNREACHABLE;
+}
+
+//
+// overlayRoute
+//
+// Answers r on the CRP overlay, customized for closed if given.
+//
+static void overlayRoute(const CampusMap &campus, const Closures *closed, SearchWorkspace &W,
+                         RouteResult &r)
+{
+    const CrpMetric &M = closed ? closed->Repaired->OverlayMetric : campus.OverlayMetric;
+    bool found = crpRoute(campus.Graph, campus.Cells, campus.Overlay, M, r.Start, r.Dest, W,
+                          r.Path, r.Miles);
+    r.Settled = W.NumSettled;
+
+    r.Status = found ? ROUTE_OK : ROUTE_UNREACHABLE;
+    if (!found)
+        r.Miles = 0.0;
+}
+
+//
+// flagRoute
+//
+// Answers r by a search pruned to the edges flagged for the
+// destination's cell.  The flags are for the open map, so a route a
+// closure spoils is searched again by Dijkstra.
+//
+static void flagRoute(const CampusMap &campus, const Closures *closed, SearchWorkspace &W,
+                      RouteResult &r)
+{
+    arcFlagSearch(campus.Graph, campus.Flags, r.Start, r.Dest, W);
+    r.Settled = W.NumSettled;
+    bool found = W.Settled[r.Dest];
+    if (found)
+        r.Path = traceCompactPath(W.Pred, r.Start, r.Dest);
+
+    if (found && closed && !pathOpen(campus.Graph, *closed, r.Path))
+    {
+        dijkstraSearch(campus.Graph, r.Start, W, std::vector<int>(1, r.Dest), QUEUE_DARY, closed);
+        r.Settled += W.NumSettled;
+        found = W.Settled[r.Dest];
+        r.Path.clear();
+        if (found)
+            r.Path = traceCompactPath(W.Pred, r.Start, r.Dest);
+    }
+
+    r.Status = found ? ROUTE_OK : ROUTE_UNREACHABLE;
+    if (found)
+        r.Miles = W.Dist[r.Dest];
+}
+
+//
+// routeQuery
+//
+void routeQuery(const CampusMap &campus, const RouteQuery &q, SearchWorkspace &W, RouteResult &r,
+                const Closures *closed)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    r = RouteResult();
+    r.Start = resolveLocation(campus, q.From);
+    r.Dest = resolveLocation(campus, q.To);
+
+    // a weighting other than the shortest needs its customized CCH
+    const CchMetric *metric = findMetric(campus, q, closed);
+    bool weighted = q.Metric != "" && q.Metric != "shortest";
+
+    if (r.Start < 0)
+        r.Status = ROUTE_START_NOT_FOUND;
+    else if (r.Dest < 0)
+        r.Status = ROUTE_DEST_NOT_FOUND;
+    else if (weighted && !metric)
+        r.Status = ROUTE_UNKNOWN_METRIC;
+    else if (!campus.Graph.sameComponent(r.Start, r.Dest))
+        r.Status = ROUTE_UNREACHABLE; // no need to search
+    else if (closed && (closed->vertexClosed(r.Start) || closed->vertexClosed(r.Dest)))
+        r.Status = ROUTE_UNREACHABLE;
+    else if (weighted)
+        metricRoute(campus, *metric, W, r);
+    else if (!campus.Labels.empty() && (!closed || !campus.Labels.Parents.empty()) &&
+             labelRoute(campus, q, closed, r))
+    {
+        // answered by one merge of the two labels
+    }
+    else if (metric)
+        metricRoute(campus, *metric, W, r);
+    else if (!campus.Overlay.empty())
+        overlayRoute(campus, closed, W, r);
+    else if (!campus.Flags.empty())
+        flagRoute(campus, closed, W, r);
+    else if (!campus.Simplified.empty() && !closed)
+    {
+        if (simplifiedRoute(campus.Graph, campus.Simplified, r.Start, r.Dest, W, r.Path, r.Miles, q.Queue))
+            r.Status = ROUTE_OK;
+        else
+            r.Status = ROUTE_UNREACHABLE;
+        r.Settled = W.NumSettled;
+    }
+    else if (!campus.Simplified.empty() &&
+             simplifiedRoute(campus.Graph, campus.Simplified, r.Start, r.Dest, W, r.Path, r.Miles, q.Queue) &&
+             pathOpen(campus.Graph, *closed, r.Path))
+    {
+        r.Status = ROUTE_OK;
+        r.Settled = W.NumSettled;
+    }
+    else
+    {
+        // (also the fallback when closures spoil a label or core route)
+        r.Path.clear();
+        if (!campus.Alt.empty())
+            altSearch(campus.Graph, campus.Alt, r.Start, r.Dest, W, closed);
+        else
+            dijkstraSearch(campus.Graph, r.Start, W, std::vector<int>(1, r.Dest), q.Queue, closed);
+        r.Settled = W.NumSettled;
+
+        if (W.Settled[r.Dest])
+        {
+            r.Status = ROUTE_OK;
+            r.Miles = W.Dist[r.Dest];
+            r.Path = traceCompactPath(W.Pred, r.Start, r.Dest);
+        }
+        else
+            r.Status = ROUTE_UNREACHABLE;
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    r.Micros = elapsed.count();
+}
+
+const char *routeStatusName(RouteStatus status)
+{
+    switch (status)
+    {
+    case ROUTE_OK:
+        return "ok";
+    case ROUTE_UNREACHABLE:
+        return "unreachable";
+    case ROUTE_START_NOT_FOUND:
+        return "start-not-found";
+    case ROUTE_DEST_NOT_FOUND:
+        return "dest-not-found";
+    case ROUTE_UNKNOWN_METRIC:
+        return "unknown-metric";
+    }
+    return "?";
+}
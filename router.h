@@ -0,0 +1,82 @@
+/*router.h*/
+
+//
+// One point-to-point route query: resolve both endpoints, search, and
+// trace the path.  Shared by the batch and interactive front ends.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "campus.h"
+#include "search.h"
+
+enum RouteStatus
+{
+    ROUTE_OK,
+    ROUTE_UNREACHABLE,
+    ROUTE_START_NOT_FOUND,
+    ROUTE_DEST_NOT_FOUND,
+    ROUTE_UNKNOWN_METRIC
+};
+
+struct RouteQuery
+{
+    std::string From; // building name/abbreviation or OSM node id
+    std::string To;
+    QueueKind Queue;  // priority queue for the search
+    bool WithPath;    // false: only the distance is needed
+    std::string Metric; // weighting (metrics.h) to route by; "" = shortest
+
+    RouteQuery()
+    {
+        Queue = QUEUE_DARY;
+        WithPath = true;
+    }
+};
+
+struct RouteResult
+{
+    RouteStatus Status;
+    int Start;             // resolved vertices, -1 if not found
+    int Dest;
+    double Miles;          // valid if Status == ROUTE_OK; walking miles,
+                           // whatever the metric
+    std::vector<int> Path; // dense vertices, start to dest
+    double Micros;         // time spent answering the query
+    long long Settled;     // vertices the search settled
+
+    RouteResult()
+    {
+        Status = ROUTE_UNREACHABLE;
+        Start = -1;
+        Dest = -1;
+        Miles = 0.0;
+        Micros = 0.0;
+        Settled = 0;
+    }
+};
+
+//
+// routeQuery
+//
+// Answers q using the workspace W (one per thread) and fills r,
+// including its timing.  With closed (see closures.h), the route
+// avoids the closed footways and nodes; the caller picks the set, so
+// that a request sees the closures made before it, not after.  The
+// CCH and the CRP overlay route on customizations repaired for the
+// closures (closures.h).  Hub labels, arc flags and the simplified
+// graph are not repaired: a route of theirs that uses something closed
+// is searched again by Dijkstra.
+//
+void routeQuery(const CampusMap &campus, const RouteQuery &q, SearchWorkspace &W, RouteResult &r,
+                const Closures *closed = nullptr);
+
+//
+// routeStatusName
+//
+// Short machine-readable name of a status ("ok", "unreachable", ...).
+//
+const char *routeStatusName(RouteStatus status);
@@ -0,0 +1,407 @@
+/*search.cpp*/
+
+//
+// Dijkstra's algorithm over the CompactGraph.
+//
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "search.h"
+
+static const long long INF_UNITS = std::numeric_limits<long long>::max();
+
+void SearchWorkspace::init(int n)
+{
+    this->Dist.assign(n, INF_DIST);
+    this->Pred.assign(n, -1);
+    this->Settled.assign(n, 0);
+    this->Marked.assign(n, 0);
+    this->Touched.clear();
+    this->NumSettled = 0;
+    this->Source = -1;
+
+    this->IntDist.assign(n, INF_UNITS);
+
+    this->BinaryQueue.init(n);
+    this->DaryQueue.init(n);
+    this->RadixQueue.init(n);
+}
+
+void SearchWorkspace::reset()
+{
+    for (int v : this->Touched)
+    {
+        this->Dist[v] = INF_DIST;
+        this->Pred[v] = -1;
+        this->Settled[v] = 0;
+        this->Marked[v] = 0;
+        this->IntDist[v] = INF_UNITS;
+    }
+    this->Touched.clear();
+    this->NumSettled = 0;
+    this->Source = -1;
+}
+
+bool parseQueueKind(const std::string &name, QueueKind &kind)
+{
+    if (name == "binary")
+        kind = QUEUE_BINARY;
+    else if (name == "dary")
+        kind = QUEUE_DARY;
+    else if (name == "radix")
+        kind = QUEUE_RADIX;
+    else if (name == "dial")
+        kind = QUEUE_DIAL;
+    else
+        return false;
+    return true;
+}
+
+//
+// markTargets
+//
+// Flags the targets so the search knows when the last one is settled
+// (the flags are cleared by the next reset); returns how many distinct
+// targets there are.
+//
+static size_t markTargets(SearchWorkspace &W, const std::vector<int> &targets)
+{
+    size_t remaining = 0;
+    for (int t : targets)
+    {
+        if (!W.Marked[t])
+        {
+            W.touch(t);
+            W.Marked[t] = 1;
+            remaining++;
+        }
+    }
+    return remaining;
+}
+
+//
+// runDijkstra
+//
+// The search itself, for any queue with the pqueue.h interface.  It
+// settles nothing farther than radius, skips what closed closes, and
+// uses weights instead of G.Weights if given.
+//
+template <typename Queue>
+static void runDijkstra(const CompactGraph &G, const std::vector<SearchSeed> &sources,
+                        SearchWorkspace &W, const std::vector<int> &targets, Queue &queue,
+                        const Closures *closed, const std::vector<double> *weights = nullptr,
+                        double radius = INF_DIST)
+{
+    size_t remaining = markTargets(W, targets);
+    const std::vector<double> &length = weights ? *weights : G.Weights;
+
+    queue.clear();
+    for (const SearchSeed &seed : sources)
+    {
+        if (seed.Dist < W.Dist[seed.Vertex])
+        {
+            W.touch(seed.Vertex);
+            W.Dist[seed.Vertex] = seed.Dist;
+            queue.update(seed.Vertex, seed.Dist);
+        }
+    }
+
+    while (!queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+
+        int u = current.second;
+        if (W.Settled[u])
+            continue; // stale entry (lazy queues only)
+        if (current.first > radius)
+            break;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+
+        if (W.Marked[u] && --remaining == 0)
+            break;
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            if (closed && closed->blocks(e, v))
+                continue;
+            double alt = current.first + length[e];
+            if (alt < W.Dist[v])
+            {
+                W.touch(v);
+                W.Dist[v] = alt;
+                W.Pred[v] = u;
+                queue.update(v, alt);
+            }
+        }
+    }
+}
+
+//
+// markBucket, unmarkBucket
+//
+// Keep the two bitmap levels of runDial in step with its buckets.
+//
+static void markBucket(SearchWorkspace &W, size_t b)
+{
+    W.BucketBits[b / 64] |= (uint64_t)1 << (b % 64);
+    W.BucketWords[b / 4096] |= (uint64_t)1 << (b / 64 % 64);
+}
+
+static void unmarkBucket(SearchWorkspace &W, size_t b)
+{
+    uint64_t &bits = W.BucketBits[b / 64];
+    bits &= ~((uint64_t)1 << (b % 64));
+    if (bits == 0)
+        W.BucketWords[b / 4096] &= ~((uint64_t)1 << (b / 64 % 64));
+}
+
+//
+// firstBucket
+//
+// The first non-empty bucket at or after from, or -1 if there is none
+// before the end of the array.
+//
+static long long firstBucket(const SearchWorkspace &W, size_t from)
+{
+    size_t word = from / 64;
+    if (word >= W.BucketBits.size())
+        return -1;
+    uint64_t bits = W.BucketBits[word] & (~(uint64_t)0 << (from % 64));
+    if (bits != 0)
+        return (long long)(word * 64 + __builtin_ctzll(bits));
+
+    // the words after it, through the summary level
+    size_t next = word + 1;
+    for (size_t group = next / 64; group < W.BucketWords.size(); ++group)
+    {
+        uint64_t words = W.BucketWords[group];
+        if (group == next / 64)
+            words &= next % 64 == 0 ? ~(uint64_t)0 : ~(uint64_t)0 << (next % 64);
+        if (words != 0)
+        {
+            size_t w = group * 64 + __builtin_ctzll(words);
+            return (long long)(w * 64 + __builtin_ctzll(W.BucketBits[w]));
+        }
+    }
+    return -1;
+}
+
+//
+// runDial
+//
+// Dial's algorithm over G.IntWeights.  Every queued distance lies in
+// [current, current + MaxIntWeight], so MaxIntWeight+1 buckets used
+// circularly never mix two different distances, and the next distance
+// is the first non-empty bucket after current's, wrapping around once.
+//
+static void runDial(const CompactGraph &G, int source, SearchWorkspace &W,
+                    const std::vector<int> &targets)
+{
+    size_t remaining = markTargets(W, targets);
+
+    size_t numBuckets = (size_t)G.MaxIntWeight + 1;
+    if (W.Buckets.size() != numBuckets)
+    {
+        W.Buckets.assign(numBuckets, std::vector<int>());
+        W.BucketBits.assign((numBuckets + 63) / 64, 0);
+        W.BucketWords.assign((numBuckets + 4095) / 4096, 0);
+    }
+
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    W.IntDist[source] = 0;
+    W.Buckets[0].push_back(source);
+    markBucket(W, 0);
+
+    size_t queued = 1;
+    long long current = 0;
+
+    while (queued > 0)
+    {
+        size_t at = current % numBuckets;
+        if (W.Buckets[at].empty())
+        {
+            long long next = firstBucket(W, at);
+            if (next < 0)
+                next = firstBucket(W, 0) + (long long)numBuckets; // wrapped
+            current += next - (long long)at;
+            at = current % numBuckets;
+        }
+
+        std::vector<int> &bucket = W.Buckets[at];
+        int u = bucket.back();
+        bucket.pop_back();
+        queued--;
+        if (bucket.empty())
+            unmarkBucket(W, at);
+
+        if (W.Settled[u])
+            continue; // stale entry
+        W.Settled[u] = 1;
+        W.NumSettled++;
+
+        if (W.Marked[u] && --remaining == 0)
+            break;
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            long long alt = current + G.IntWeights[e];
+            if (alt < W.IntDist[v])
+            {
+                W.touch(v);
+                W.IntDist[v] = alt;
+                W.Dist[v] = alt / G.UnitsPerMile;
+                W.Pred[v] = u;
+                size_t b = alt % numBuckets;
+                W.Buckets[b].push_back(v);
+                markBucket(W, b);
+                queued++;
+            }
+        }
+    }
+
+    // stopped early: empty the buckets still marked for the next search
+    if (queued > 0)
+    {
+        for (size_t group = 0; group < W.BucketWords.size(); ++group)
+        {
+            for (uint64_t words = W.BucketWords[group]; words != 0; words &= words - 1)
+            {
+                size_t w = group * 64 + __builtin_ctzll(words);
+                for (uint64_t bits = W.BucketBits[w]; bits != 0; bits &= bits - 1)
+                    W.Buckets[w * 64 + __builtin_ctzll(bits)].clear();
+                W.BucketBits[w] = 0;
+            }
+            W.BucketWords[group] = 0;
+        }
+    }
+}
+
+//
+// dijkstraSearch
+//
+void dijkstraSearch(const CompactGraph &G, const std::vector<SearchSeed> &sources,
+                    SearchWorkspace &W, const std::vector<int> &targets, QueueKind queue,
+                    const Closures *closed, const std::vector<double> *weights)
+{
+    if ((int)W.Dist.size() != G.NumVertices())
+        W.init(G.NumVertices());
+    else
+        W.reset();
+
+    bool singleSource = (sources.size() == 1 && sources[0].Dist == 0.0);
+
+    switch (queue)
+    {
+    case QUEUE_BINARY:
+        runDijkstra(G, sources, W, targets, W.BinaryQueue, closed, weights);
+        break;
+    case QUEUE_RADIX:
+        runDijkstra(G, sources, W, targets, W.RadixQueue, closed, weights);
+        break;
+    case QUEUE_DIAL:
+        if (!G.IntWeights.empty() && singleSource && !closed && !weights)
+        {
+            runDial(G, sources[0].Vertex, W, targets);
+            break;
+        }
+        // fall through
+    case QUEUE_DARY:
+        runDijkstra(G, sources, W, targets, W.DaryQueue, closed, weights);
+        break;
+    }
+}
+
+void dijkstraSearch(const CompactGraph &G, int source, SearchWorkspace &W,
+                    const std::vector<int> &targets, QueueKind queue, const Closures *closed,
+                    const std::vector<double> *weights)
+{
+    dijkstraSearch(G, std::vector<SearchSeed>(1, SearchSeed(source, 0.0)), W, targets, queue, closed,
+                   weights);
+}
+
+//
+// boundedSearch
+//
+void boundedSearch(const CompactGraph &G, int source, double radius, SearchWorkspace &W,
+                   const Closures *closed)
+{
+    if ((int)W.Dist.size() != G.NumVertices())
+        W.init(G.NumVertices());
+    else
+        W.reset();
+
+    runDijkstra(G, std::vector<SearchSeed>(1, SearchSeed(source, 0.0)), W,
+                std::vector<int>(), W.DaryQueue, closed, nullptr, radius);
+}
+
+//
+// startSearch
+//
+void startSearch(const CompactGraph &G, int source, SearchWorkspace &W)
+{
+    if ((int)W.Dist.size() != G.NumVertices())
+        W.init(G.NumVertices());
+    else
+        W.reset();
+
+    W.DaryQueue.clear();
+    W.touch(source);
+    W.Dist[source] = 0.0;
+    W.DaryQueue.update(source, 0.0);
+    W.Source = source;
+}
+
+//
+// resumeSearch
+//
+// Unlike runDijkstra, it relaxes the target's edges before stopping,
+// so the queue is a complete frontier for the next target.
+//
+bool resumeSearch(const CompactGraph &G, int target, SearchWorkspace &W)
+{
+    IndexedDaryHeap<4> &queue = W.DaryQueue;
+
+    while (!W.Settled[target] && !queue.empty())
+    {
+        std::pair<double, int> current = queue.pop();
+
+        int u = current.second;
+        W.Settled[u] = 1;
+        W.NumSettled++;
+
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            int v = G.Targets[e];
+            double alt = current.first + G.Weights[e];
+            if (alt < W.Dist[v])
+            {
+                W.touch(v);
+                W.Dist[v] = alt;
+                W.Pred[v] = u;
+                queue.update(v, alt);
+            }
+        }
+    }
+    return W.Settled[target] != 0;
+}
+
+//
+// traceCompactPath
+//
+std::vector<int> traceCompactPath(const std::vector<int> &pred, int source, int target)
+{
+    std::vector<int> path;
+    if (target < 0 || (target != source && pred[target] == -1))
+        return path;
+
+    for (int v = target; v != -1; v = pred[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,200 @@
+/*search.h*/
+
+//
+// Dijkstra's algorithm over the CompactGraph.
+//
+// All per-search state lives in a SearchWorkspace that is sized once
+// for the graph and then reused: a search only resets the vertices it
+// touched, so a short search costs time proportional to the area it
+// explored rather than to the size of the graph.  A workspace must not
+// be shared between threads; give each thread its own.
+//
+// The priority queue is chosen per search (see pqueue.h).  The indexed
+// 4-ary heap is the default: it does a real decrease-key, so no vertex
+// is ever queued twice.
+//
+// QUEUE_DIAL runs Dial's algorithm on the quantized weights instead:
+// integer distances in a circular array of MaxIntWeight+1 buckets, so
+// queue operations are O(1) and compares are integer compares.  A
+// two-level bitmap of the non-empty buckets lets the scan for the next
+// distance skip 64 (or 4096) empty buckets at a time, since with fine
+// units most buckets between two queued distances are empty.  Dist
+// is still reported in miles (the integer distance / UnitsPerMile), and
+// differs from the exact double search by at most half a unit per edge
+// of the longer path -- with centimeters, under 0.5 cm per edge.  On a
+// graph without IntWeights, for a search with several sources, or for
+// one that honors closures or other weights, it falls back to the
+// 4-ary heap.
+//
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstdint>
+
+#include "compactgraph.h"
+#include "pqueue.h"
+#include "closures.h"
+
+const double INF_DIST = std::numeric_limits<double>::max();
+
+enum QueueKind
+{
+    QUEUE_BINARY, // lazy std::priority_queue
+    QUEUE_DARY,   // indexed 4-ary heap with decrease-key
+    QUEUE_RADIX,  // monotone radix heap
+    QUEUE_DIAL    // bucket queue over quantized integer weights
+};
+
+//
+// parseQueueKind
+//
+// "binary", "dary", "radix" or "dial"; returns false for anything else.
+//
+bool parseQueueKind(const std::string &name, QueueKind &kind);
+
+struct SearchWorkspace
+{
+    std::vector<double> Dist;  // INF_DIST if not reached
+    std::vector<int> Pred;     // -1 for the source / unreached vertices
+    std::vector<char> Settled; // 1 once Dist is final
+    std::vector<char> Marked;  // scratch flags (e.g. targets)
+    std::vector<int> Touched;  // vertices to clear on reset
+    long long NumSettled;      // stats for the last search
+    int Source;                // source of the search startSearch began, -1 once reset
+
+    LazyBinaryHeap BinaryQueue;
+    IndexedDaryHeap<4> DaryQueue;
+    RadixHeap RadixQueue;
+
+    std::vector<long long> IntDist;       // QUEUE_DIAL distances, in units
+    std::vector<std::vector<int>> Buckets; // QUEUE_DIAL circular buckets
+    std::vector<uint64_t> BucketBits;      // bit b: Buckets[b] is not empty
+    std::vector<uint64_t> BucketWords;     // bit w: BucketBits[w] is not 0
+
+    SearchWorkspace()
+    {
+        NumSettled = 0;
+        Source = -1;
+    }
+
+    //
+    // init
+    //
+    // Sizes the workspace for a graph with n vertices; every vertex
+    // starts out unreached.
+    //
+    void init(int n);
+
+    //
+    // reset
+    //
+    // Returns every touched vertex to the unreached state.
+    //
+    void reset();
+
+    //
+    // touch
+    //
+    // Records v for the next reset the first time it is reached.
+    //
+    void touch(int v)
+    {
+        if (this->Dist[v] == INF_DIST && !this->Marked[v])
+            this->Touched.push_back(v);
+    }
+};
+
+//
+// SearchSeed
+//
+// A start vertex together with the distance it starts at.
+//
+struct SearchSeed
+{
+    int Vertex;
+    double Dist;
+
+    SearchSeed(int vertex, double dist)
+    {
+        Vertex = vertex;
+        Dist = dist;
+    }
+};
+
+//
+// dijkstraSearch
+//
+// Computes shortest paths from source into W (which is reset first).
+// If targets is non-empty, the search stops as soon as every target
+// is settled; otherwise it computes the whole shortest-path tree.
+// With closed, it never uses a closed edge or enters a closed vertex.
+// With weights (one per edge), it searches by them instead of G.Weights
+// (see metrics.h).
+//
+void dijkstraSearch(const CompactGraph &G, int source, SearchWorkspace &W,
+                    const std::vector<int> &targets = std::vector<int>(),
+                    QueueKind queue = QUEUE_DARY,
+                    const Closures *closed = nullptr,
+                    const std::vector<double> *weights = nullptr);
+
+//
+// dijkstraSearch (several sources)
+//
+// The same, starting from every seed at once: Dist[v] is the least
+// seed distance plus path length over all seeds, and following Pred
+// from v ends at the seed it came from.
+//
+void dijkstraSearch(const CompactGraph &G, const std::vector<SearchSeed> &sources,
+                    SearchWorkspace &W,
+                    const std::vector<int> &targets = std::vector<int>(),
+                    QueueKind queue = QUEUE_DARY,
+                    const Closures *closed = nullptr,
+                    const std::vector<double> *weights = nullptr);
+
+//
+// boundedSearch
+//
+// Settles exactly the vertices within radius miles of source.  Its
+// cost depends on the area reached, not on the graph: W.Touched holds
+// the settled vertices plus the frontier just beyond the radius.
+//
+void boundedSearch(const CompactGraph &G, int source, double radius, SearchWorkspace &W,
+                   const Closures *closed = nullptr);
+
+//
+// startSearch / resumeSearch
+//
+// A search that grows only as far as the queries asked of it so far.
+// startSearch resets W and queues source; resumeSearch settles vertices
+// until target is settled, so a later target from the same source
+// picks up where the last one stopped -- the frontier is still in
+// W.DaryQueue -- instead of searching again.  Returns whether target
+// was reached.  The settled part is exactly the tree dijkstraSearch
+// would build (same queue, same order).  Any other search in W ends
+// it; W.Source tells whether it is still there.
+//
+void startSearch(const CompactGraph &G, int source, SearchWorkspace &W);
+bool resumeSearch(const CompactGraph &G, int target, SearchWorkspace &W);
+
+//
+// searchComplete
+//
+// True once a resumable search has settled everything it can reach,
+// so W holds the whole shortest-path tree.
+//
+inline bool searchComplete(const SearchWorkspace &W)
+{
+    return W.Source >= 0 && W.DaryQueue.empty();
+}
+
+//
+// traceCompactPath
+//
+// Follows Pred from target back to source and returns the path in
+// source-to-target order.  Returns an empty vector if target was not
+// reached.
+//
+std::vector<int> traceCompactPath(const std::vector<int> &pred, int source, int target);
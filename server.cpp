@@ -0,0 +1,1124 @@
+/*server.cpp*/
+
+//
+// Long-running routing server.
+//
+
+#include <iostream>
+
+#include "server.h"
+
+#ifndef __linux__
+
+int runServer(MapSnapshot &maps, const ServerOptions &options)
+{
+    std::cerr << "**Error: server mode requires Linux." << std::endl;
+    return 1;
+}
+
+#else
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <memory>
+
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "search.h"
+#include "router.h"
+#include "isochrone.h"
+#include "alternatives.h"
+#include "tour.h"
+#include "nearest.h"
+#include "dstarlite.h"
+#include "threadpool.h"
+
+namespace
+{
+// a connection is dropped if it sends a line longer than this
+const size_t MAX_LINE = 1 << 16;
+
+// STATS percentiles are taken over the most recent requests
+const size_t LATENCY_WINDOW = 1 << 14;
+
+// ALTERNATIVES answers at most this many routes
+const int MAX_ALTERNATIVES = 20;
+
+// TOUR plans at most this many stops
+const int MAX_TOUR_STOPS = 64;
+
+// at most this many replanning sessions are open at once, and fewer
+// on a map so big that their D* Lite state, DSTAR_BYTES_PER_VERTEX for
+// every vertex of the map each, would exceed SESSION_BUDGET_BYTES
+const size_t MAX_SESSIONS = 1024;
+const size_t SESSION_BUDGET_BYTES = (size_t)256 << 20;
+
+// a session that has not been used for this long is dropped
+const int SESSION_IDLE_SECONDS = 600;
+
+// the event loop sweeps the session table this often
+const int SESSION_SWEEP_MS = 1000;
+
+// MOVE trusts a snap found by walking from the last start if it is
+// within this many miles of the position (about 50 feet)
+const double LOCAL_SNAP_MILES = 0.01;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Connection
+{
+    int fd;
+    std::string in;  // received, not yet split into lines
+    std::string out; // ready to send
+    unsigned long long nextSeq;  // sequence number of the next request
+    unsigned long long nextSend; // sequence number of the next response
+    std::map<unsigned long long, std::string> ready; // finished out of order
+    bool peerClosed;
+    unsigned events; // what epoll is watching for
+
+    Connection()
+    {
+        fd = -1;
+        nextSeq = 0;
+        nextSend = 0;
+        peerClosed = false;
+        events = 0;
+    }
+};
+
+//
+// ReplanSession
+//
+// A walker's route, kept up to date by D* Lite between requests.
+// Requests on one session may run on different workers; Lock makes
+// them take turns.  LastUsed belongs to the session table's lock.
+//
+// The destination is also kept by OSM node id and position, so that
+// after a reload the session can let go of the old snapshot (Campus
+// and Planner are then reset) and start over on the new one.
+//
+struct ReplanSession
+{
+    std::mutex Lock;
+    MapSnapshot::Ptr Campus; // the snapshot Planner's state refers to, or none
+    DStarLite Planner;
+    long long GoalId;        // OSM node id of the destination
+    double GoalLat;
+    double GoalLon;
+    Clock::time_point LastUsed;
+
+    ReplanSession()
+    {
+        GoalId = -1;
+        GoalLat = 0.0;
+        GoalLon = 0.0;
+    }
+};
+
+struct Completion
+{
+    unsigned long long Conn;
+    unsigned long long Seq;
+    std::string Response;
+    double Micros;
+};
+
+//
+// LatencyWindow
+//
+// The last LATENCY_WINDOW request latencies, in microseconds.
+//
+class LatencyWindow
+{
+private:
+    std::vector<double> samples;
+    size_t next;
+
+public:
+    LatencyWindow()
+    {
+        this->next = 0;
+    }
+
+    void add(double micros)
+    {
+        if (this->samples.size() < LATENCY_WINDOW)
+            this->samples.push_back(micros);
+        else
+            this->samples[this->next] = micros;
+        this->next = (this->next + 1) % LATENCY_WINDOW;
+    }
+
+    std::vector<double> sorted() const
+    {
+        std::vector<double> s = this->samples;
+        std::sort(s.begin(), s.end());
+        return s;
+    }
+};
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+std::vector<std::string> splitFields(const std::string &line)
+{
+    return splitStr(line, '\t');
+}
+
+//
+// answerRequest
+//
+// Runs on a pool worker: everything it reads is immutable.  closed
+// is the set of closures when the request was read (nullptr if
+// none).  W2 is a second workspace for the requests that need two
+// trees at once.
+//
+std::string answerRequest(const CampusMap &campus, const Closures *closed, const std::string &line,
+                          SearchWorkspace &W, SearchWorkspace &W2)
+{
+    std::vector<std::string> fields = splitFields(line);
+    std::ostringstream out;
+    out << std::setprecision(8);
+
+    if (fields.empty())
+        return "ERR\tempty request";
+
+    const CompactGraph &G = campus.Graph;
+    const std::string &command = fields[0];
+
+    if (command == "ROUTE" && (fields.size() == 3 || fields.size() == 4))
+    {
+        RouteQuery q;
+        q.From = fields[1];
+        q.To = fields[2];
+        if (fields.size() == 4)
+            q.Metric = fields[3];
+        RouteResult r;
+        routeQuery(campus, q, W, r, closed);
+
+        if (r.Status != ROUTE_OK)
+            return std::string("ERR\t") + routeStatusName(r.Status);
+
+        out << "OK\t" << r.Miles << "\t";
+        for (size_t i = 0; i < r.Path.size(); ++i)
+            out << (i > 0 ? " " : "") << G.IDs[r.Path[i]];
+        return out.str();
+    }
+
+    if (command == "SNAP" && fields.size() == 3)
+    {
+        int v = snapLocation(campus, std::atof(fields[1].c_str()), std::atof(fields[2].c_str()));
+        if (v < 0)
+            return "ERR\tempty map";
+        out << "OK\t" << G.IDs[v] << "\t" << G.Lat[v] << "\t" << G.Lon[v];
+        return out.str();
+    }
+
+    if (command == "LOOKUP" && fields.size() == 2)
+    {
+        BuildingInfo building;
+        if (!setBuildingInfo(campus.BuildingsAbbreviation, campus.BuildingsFullname, building, fields[1]))
+            return "ERR\tnot-found";
+
+        auto snapped = campus.BuildingVertex.find(building.Coords.ID);
+        out << "OK\t" << building.Fullname << "\t" << building.Abbrev << "\t"
+            << building.Coords.Lat << "\t" << building.Coords.Lon << "\t";
+        if (snapped != campus.BuildingVertex.end() && snapped->second >= 0)
+            out << G.IDs[snapped->second];
+        return out.str();
+    }
+
+    if ((command == "ISOCHRONE" || command == "REACHABLE") && fields.size() == 3)
+    {
+        int source = resolveLocation(campus, fields[1]);
+        char *end;
+        double radius = std::strtod(fields[2].c_str(), &end);
+        if (source < 0)
+            return "ERR\tstart-not-found";
+        if (end == fields[2].c_str() || *end != '\0' || !(radius >= 0.0))
+            return "ERR\tbad radius";
+
+        Isochrone iso;
+        computeIsochrone(G, source, radius, W, iso, command == "ISOCHRONE", closed);
+
+        if (command == "REACHABLE")
+        {
+            out << "OK\t";
+            for (size_t i = 0; i < iso.Reached.size(); ++i)
+                out << (i > 0 ? " " : "") << G.IDs[iso.Reached[i]];
+            return out.str();
+        }
+
+        out << "OK\t" << iso.Reached.size() << "\t";
+        for (size_t i = 0; i < iso.Hull.size(); ++i)
+            out << (i > 0 ? " " : "") << iso.Hull[i].Lat << "," << iso.Hull[i].Lon;
+        return out.str();
+    }
+
+    if (command == "ALTERNATIVES" && (fields.size() == 4 || fields.size() == 5))
+    {
+        int source = resolveLocation(campus, fields[1]);
+        int target = resolveLocation(campus, fields[2]);
+        int k = std::atoi(fields[3].c_str());
+        std::string method = fields.size() == 5 ? fields[4] : "yen";
+        if (source < 0)
+            return "ERR\tstart-not-found";
+        if (target < 0)
+            return "ERR\tdest-not-found";
+        if (k < 1 || k > MAX_ALTERNATIVES)
+            return "ERR\tbad count";
+        if (method != "yen" && method != "plateau")
+            return "ERR\tbad method";
+        if (!G.sameComponent(source, target))
+            return "ERR\tunreachable";
+
+        Alternatives A;
+        if (method == "yen")
+            kShortestPaths(G, source, target, k, W, W2, A, closed);
+        else
+            plateauAlternatives(G, source, target, k, W, W2, A, closed);
+
+        out << "OK\t" << A.Searches;
+        for (const AlternativeRoute &route : A.Routes)
+        {
+            out << "\t" << route.Miles << "\t";
+            for (size_t i = 0; i < route.Path.size(); ++i)
+                out << (i > 0 ? " " : "") << G.IDs[route.Path[i]];
+        }
+        return out.str();
+    }
+
+    if (command == "TOUR" && fields.size() >= 3)
+    {
+        TourKind kind;
+        if (fields[1] == "open")
+            kind = TOUR_OPEN;
+        else if (fields[1] == "round")
+            kind = TOUR_ROUND_TRIP;
+        else
+            return "ERR\tbad kind";
+        if (fields.size() - 2 > (size_t)MAX_TOUR_STOPS)
+            return "ERR\ttoo many stops";
+
+        std::vector<int> stops;
+        for (size_t i = 2; i < fields.size(); ++i)
+        {
+            int v = resolveLocation(campus, fields[i]);
+            if (v < 0)
+                return "ERR\tstop-not-found\t" + fields[i];
+            stops.push_back(v);
+        }
+
+        // on a pool worker already: build the table on this thread
+        TourPlan plan;
+        if (!planTour(campus, stops, kind, 1, plan, closed))
+            return "ERR\tunreachable";
+
+        out << "OK\t" << plan.Miles << "\t";
+        for (size_t i = 0; i < plan.Order.size(); ++i)
+            out << (i > 0 ? " " : "") << plan.Order[i];
+        out << "\t";
+        for (size_t i = 0; i < plan.Path.size(); ++i)
+            out << (i > 0 ? " " : "") << G.IDs[plan.Path[i]];
+        return out.str();
+    }
+
+    if (command == "NEAREST" && fields.size() == 3)
+    {
+        int origin = resolveLocation(campus, fields[1]);
+        if (origin < 0)
+            return "ERR\tstart-not-found";
+
+        NearestResult r;
+        nearestBuilding(campus, origin, fields[2], W, r, closed);
+        if (r.Building < 0)
+            return "ERR\tnot-found";
+
+        const BuildingInfo &building = campus.Buildings[r.Building];
+        out << "OK\t" << building.Fullname << "\t" << building.Abbrev << "\t" << r.Miles << "\t";
+        for (size_t i = 0; i < r.Path.size(); ++i)
+            out << (i > 0 ? " " : "") << G.IDs[r.Path[i]];
+        return out.str();
+    }
+
+    return "ERR\tbad request";
+}
+
+//
+// shutdownSignals
+//
+// The signals the event loop reads from its signalfd (SIGHUP reloads
+// the map, the others shut down).  They must be
+// blocked in every thread, so this is done before the pool starts.
+//
+sigset_t shutdownSignals()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    return signals;
+}
+
+bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int openListener(const ServerOptions &options)
+{
+    int fd;
+
+    if (options.TcpPort > 0)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)options.TcpPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    else
+    {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (options.SocketPath.size() >= sizeof(addr.sun_path))
+            return -1;
+        std::strcpy(addr.sun_path, options.SocketPath.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        unlink(options.SocketPath.c_str()); // stale socket from an earlier run
+        if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//
+// Server
+//
+// The event loop.  Only the loop thread touches connections; workers
+// hand their responses back through the completion list and wake the
+// loop with the eventfd.
+//
+class Server
+{
+private:
+    MapSnapshot &maps;
+    std::unique_ptr<WorkStealingPool> pool;
+    std::vector<SearchWorkspace> workspaces; // two per worker
+
+    int epollFd;
+    int listenFd;
+    int wakeFd;
+    int signalFd;
+
+    std::map<unsigned long long, Connection> connections;
+    std::map<int, unsigned long long> byFd;
+    unsigned long long nextConnection;
+
+    std::mutex completionLock;
+    std::vector<Completion> completions;
+
+    std::mutex sessionLock;
+    std::map<unsigned long long, std::shared_ptr<ReplanSession>> sessions;
+    unsigned long long nextSession;
+
+    std::atomic<long long> inFlight;
+    long long maxInFlight;
+    long long served;
+    LatencyWindow latencies;
+
+    void watch(int fd, unsigned events, int op)
+    {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(this->epollFd, op, fd, &ev);
+    }
+
+    void closeConnection(unsigned long long id)
+    {
+        auto it = this->connections.find(id);
+        if (it == this->connections.end())
+            return;
+        epoll_ctl(this->epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        this->byFd.erase(it->second.fd);
+        this->connections.erase(it);
+    }
+
+    void acceptConnections()
+    {
+        while (true)
+        {
+            int fd = accept(this->listenFd, nullptr, nullptr);
+            if (fd < 0)
+                return;
+            if (!setNonBlocking(fd))
+            {
+                close(fd);
+                continue;
+            }
+
+            unsigned long long id = this->nextConnection++;
+            Connection &c = this->connections[id];
+            c.fd = fd;
+            c.events = EPOLLIN | EPOLLRDHUP;
+            this->byFd[fd] = id;
+            this->watch(fd, c.events, EPOLL_CTL_ADD);
+        }
+    }
+
+    std::string statsLine()
+    {
+        std::vector<double> sorted = this->latencies.sorted();
+        std::ostringstream out;
+        out << std::setprecision(6);
+        out << "OK\trequests=" << this->served
+            << "\tqueue=" << this->inFlight.load()
+            << "\tmax_queue=" << this->maxInFlight
+            << "\tp50_us=" << percentile(sorted, 0.50)
+            << "\tp90_us=" << percentile(sorted, 0.90)
+            << "\tp99_us=" << percentile(sorted, 0.99)
+            << "\tmax_us=" << (sorted.empty() ? 0.0 : sorted.back())
+            << "\tgeneration=" << this->maps.Generation()
+            << "\treloading=" << (this->maps.Reloading() ? 1 : 0);
+        return out.str();
+    }
+
+    //
+    // closureCommand
+    //
+    // CLOSE / OPEN, answered on the loop thread so that requests after
+    // it on the connection already see the change.
+    //
+    std::string closureCommand(const std::string &line)
+    {
+        std::vector<std::string> fields = splitFields(line);
+        std::vector<long long> ids;
+        for (size_t i = 1; i < fields.size(); ++i)
+        {
+            char *end;
+            ids.push_back(std::strtoll(fields[i].c_str(), &end, 10));
+            if (end == fields[i].c_str() || *end != '\0')
+                return "ERR\tbad node id";
+        }
+        if (ids.empty() || ids.size() > 2)
+            return "ERR\tbad request";
+
+        if (!this->maps.setClosed(ids, fields[0] == "CLOSE"))
+            return ids.size() == 2 ? "ERR\tnot-a-segment" : "ERR\tnot-found";
+
+        ClosuresPtr closures = this->maps.closures();
+        std::ostringstream out;
+        out << "OK\tsegments=" << closures->Segments.size() << "\tnodes=" << closures->Nodes.size();
+        return out.str();
+    }
+
+    //
+    // isSessionRequest
+    //
+    // SESSION, MOVE and END work on the session table instead of
+    // answerRequest's immutable state.
+    //
+    static bool isSessionRequest(const std::string &line)
+    {
+        return line.compare(0, 8, "SESSION\t") == 0 || line.compare(0, 5, "MOVE\t") == 0 ||
+               line.compare(0, 4, "END\t") == 0;
+    }
+
+    //
+    // findSession
+    //
+    // The session with the given id (nullptr if there is none), marked
+    // as just used.
+    //
+    std::shared_ptr<ReplanSession> findSession(const std::string &id)
+    {
+        std::lock_guard<std::mutex> guard(this->sessionLock);
+        auto it = this->sessions.find(std::strtoull(id.c_str(), nullptr, 10));
+        if (it == this->sessions.end())
+            return nullptr;
+        it->second->LastUsed = Clock::now();
+        return it->second;
+    }
+
+    //
+    // dropIdleSessions
+    //
+    // Forgets the sessions unused for SESSION_IDLE_SECONDS; the caller
+    // holds sessionLock.
+    //
+    void dropIdleSessions(Clock::time_point now)
+    {
+        for (auto it = this->sessions.begin(); it != this->sessions.end();)
+        {
+            if (now - it->second->LastUsed > std::chrono::seconds(SESSION_IDLE_SECONDS))
+                it = this->sessions.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    //
+    // sweepSessions
+    //
+    // On the loop thread, every SESSION_SWEEP_MS: drops the idle
+    // sessions, and makes the ones still on a replaced snapshot let go
+    // of it, so that an idle session never keeps an old map alive.  A
+    // session busy on a worker is left for the next sweep.
+    //
+    void sweepSessions()
+    {
+        MapSnapshot::Ptr current = this->maps.acquire();
+        std::lock_guard<std::mutex> guard(this->sessionLock);
+        this->dropIdleSessions(Clock::now());
+
+        for (auto &entry : this->sessions)
+        {
+            ReplanSession &session = *entry.second;
+            if (!session.Campus || session.Campus == current)
+                continue;
+            std::unique_lock<std::mutex> busy(session.Lock, std::try_to_lock);
+            if (!busy.owns_lock())
+                continue;
+            session.Campus.reset();
+            session.Planner = DStarLite();
+        }
+    }
+
+    //
+    // sessionLimit
+    //
+    // How many sessions may be open at once on a map of numVertices.
+    //
+    static size_t sessionLimit(int numVertices)
+    {
+        size_t each = std::max((size_t)1, (size_t)numVertices * DSTAR_BYTES_PER_VERTEX);
+        return std::max((size_t)1, std::min(MAX_SESSIONS, SESSION_BUDGET_BYTES / each));
+    }
+
+    //
+    // sessionsFull
+    //
+    // True if no session may be added on a map of numVertices, checked
+    // before the new one allocates its state.
+    //
+    bool sessionsFull(int numVertices)
+    {
+        std::lock_guard<std::mutex> guard(this->sessionLock);
+        return this->sessions.size() >= sessionLimit(numVertices);
+    }
+
+    //
+    // addSession
+    //
+    // Stores a new session, first dropping the idle ones.  Returns its
+    // id, or 0 if the table is full.
+    //
+    unsigned long long addSession(const std::shared_ptr<ReplanSession> &session)
+    {
+        std::lock_guard<std::mutex> guard(this->sessionLock);
+        Clock::time_point now = Clock::now();
+        this->dropIdleSessions(now);
+        if (this->sessions.size() >= sessionLimit(session->Campus->Graph.NumVertices()))
+            return 0;
+
+        unsigned long long id = this->nextSession++;
+        session->LastUsed = now;
+        this->sessions[id] = session;
+        return id;
+    }
+
+    //
+    // sessionRequest
+    //
+    // SESSION / MOVE / END, on a pool worker.  campus and closures are
+    // the snapshot and closures when the request was read; a session
+    // started on an older snapshot is started over on it at its next
+    // MOVE.
+    //
+    std::string sessionRequest(const MapSnapshot::Ptr &campus, const ClosuresPtr &closures,
+                               const std::string &line)
+    {
+        std::vector<std::string> fields = splitFields(line);
+        std::ostringstream out;
+        out << std::setprecision(8);
+
+        if (fields[0] == "END" && fields.size() == 2)
+        {
+            std::lock_guard<std::mutex> guard(this->sessionLock);
+            if (this->sessions.erase(std::strtoull(fields[1].c_str(), nullptr, 10)) == 0)
+                return "ERR\tno-session";
+            return "OK";
+        }
+
+        std::shared_ptr<ReplanSession> session;
+
+        if (fields[0] == "SESSION" && fields.size() == 3)
+        {
+            int start = resolveLocation(*campus, fields[1]);
+            int goal = resolveLocation(*campus, fields[2]);
+            if (start < 0)
+                return "ERR\tstart-not-found";
+            if (goal < 0)
+                return "ERR\tdest-not-found";
+            if (!campus->Graph.sameComponent(start, goal))
+                return "ERR\tunreachable";
+
+            if (this->sessionsFull(campus->Graph.NumVertices()))
+                return "ERR\ttoo many sessions";
+
+            // not in the table yet, so no one else can see it
+            session = std::make_shared<ReplanSession>();
+            session->Campus = campus;
+            session->GoalId = campus->Graph.IDs[goal];
+            session->GoalLat = campus->Graph.Lat[goal];
+            session->GoalLon = campus->Graph.Lon[goal];
+            session->Planner.init(campus->Graph, start, goal, closures);
+            if (!session->Planner.replan())
+                return "ERR\tunreachable";
+
+            unsigned long long id = this->addSession(session);
+            if (id == 0)
+                return "ERR\ttoo many sessions";
+            out << "OK\t" << id << "\t";
+        }
+        else if (fields[0] == "MOVE" && (fields.size() == 3 || fields.size() == 4))
+        {
+            session = this->findSession(fields[1]);
+            if (!session)
+                return "ERR\tno-session";
+            out << "OK\t";
+        }
+        else
+            return "ERR\tbad request";
+
+        std::lock_guard<std::mutex> guard(session->Lock);
+        DStarLite &D = session->Planner;
+
+        if (fields[0] == "MOVE")
+        {
+            // where is the walker?  A node, a building, or "<lat> <lon>":
+            int start;
+            bool sameMap = session->Campus == campus;
+            if (fields.size() == 3)
+                start = resolveLocation(*campus, fields[2]);
+            else
+            {
+                double lat = std::atof(fields[2].c_str()), lon = std::atof(fields[3].c_str());
+                const CompactGraph &G = campus->Graph;
+                start = sameMap ? walkToNearest(G, D.Start(), lat, lon) : -1;
+                if (start < 0 || straightLineMiles(lat, lon, G.Lat[start], G.Lon[start]) > LOCAL_SNAP_MILES)
+                    start = snapLocation(*campus, lat, lon);
+            }
+            if (start < 0)
+                return "ERR\tstart-not-found";
+
+            if (!sameMap)
+            {
+                // the map was reloaded: keep the destination, start over
+                int goal = campus->Graph.vertexOf(session->GoalId);
+                if (goal < 0)
+                    goal = snapLocation(*campus, session->GoalLat, session->GoalLon);
+                if (goal < 0)
+                    return "ERR\tdest-not-found";
+                session->Campus = campus;
+                D.init(campus->Graph, start, goal, closures);
+            }
+            else
+            {
+                D.moveStart(start);
+                D.updateClosures(closures);
+            }
+
+            if (!campus->Graph.sameComponent(D.Start(), D.Goal()) || !D.replan())
+                return "ERR\tunreachable";
+        }
+
+        const CompactGraph &G = session->Campus->Graph;
+        std::vector<int> path = D.path();
+        out << D.miles() << "\t";
+        for (size_t i = 0; i < path.size(); ++i)
+            out << (i > 0 ? " " : "") << G.IDs[path[i]];
+        return out.str();
+    }
+
+    void submit(unsigned long long id, unsigned long long seq, const std::string &line)
+    {
+        long long depth = ++this->inFlight;
+        this->maxInFlight = std::max(this->maxInFlight, depth);
+        Clock::time_point received = Clock::now();
+
+        //
+        // the map and closures as of this line: a CLOSE, OPEN or RELOAD
+        // pipelined after it is applied right away on this thread, and
+        // must not change the answer.  The snapshot stays alive until
+        // this request is done, even if a reload replaces it meanwhile.
+        //
+        MapSnapshot::Ptr campus = this->maps.acquire();
+        ClosuresPtr closures = currentClosures(*campus);
+
+        this->pool->submit([this, id, seq, line, received, campus, closures](int worker) {
+            Completion c;
+            c.Conn = id;
+            c.Seq = seq;
+            if (isSessionRequest(line))
+                c.Response = this->sessionRequest(campus, closures, line);
+            else
+                c.Response = answerRequest(*campus, activeClosures(closures), line,
+                                           this->workspaces[2 * worker],
+                                           this->workspaces[2 * worker + 1]);
+            std::chrono::duration<double, std::micro> elapsed = Clock::now() - received;
+            c.Micros = elapsed.count();
+            {
+                std::lock_guard<std::mutex> guard(this->completionLock);
+                this->completions.push_back(std::move(c));
+            }
+            uint64_t one = 1;
+            ssize_t ignored = write(this->wakeFd, &one, sizeof(one));
+            (void)ignored;
+        });
+    }
+
+    void readConnection(unsigned long long id)
+    {
+        Connection &c = this->connections[id];
+        char buffer[1 << 14];
+
+        while (true)
+        {
+            ssize_t n = read(c.fd, buffer, sizeof(buffer));
+            if (n > 0)
+            {
+                c.in.append(buffer, n);
+                continue;
+            }
+            if (n == 0)
+                c.peerClosed = true;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                this->closeConnection(id);
+                return;
+            }
+            break;
+        }
+
+        //
+        // split off complete lines; each one becomes a request:
+        //
+        size_t start = 0, newline;
+        while ((newline = c.in.find('\n', start)) != std::string::npos)
+        {
+            std::string line = c.in.substr(start, newline - start);
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            start = newline + 1;
+
+            unsigned long long seq = c.nextSeq++;
+            if (line == "STATS")
+                this->complete(c, seq, this->statsLine());
+            else if (line == "RELOAD")
+                this->complete(c, seq, this->maps.reload() ? "OK\treloading" : "ERR\treload in progress");
+            else if (line.compare(0, 6, "CLOSE\t") == 0 || line.compare(0, 5, "OPEN\t") == 0)
+                this->complete(c, seq, this->closureCommand(line));
+            else
+                this->submit(id, seq, line);
+        }
+        c.in.erase(0, start);
+
+        if (c.in.size() > MAX_LINE)
+        {
+            this->closeConnection(id);
+            return;
+        }
+        this->flushConnection(id);
+    }
+
+    void complete(Connection &c, unsigned long long seq, const std::string &response)
+    {
+        c.ready[seq] = response;
+        auto it = c.ready.begin();
+        while (it != c.ready.end() && it->first == c.nextSend)
+        {
+            c.out += it->second;
+            c.out += '\n';
+            c.nextSend++;
+            it = c.ready.erase(it);
+        }
+    }
+
+    void flushConnection(unsigned long long id)
+    {
+        auto it = this->connections.find(id);
+        if (it == this->connections.end())
+            return;
+        Connection &c = it->second;
+
+        while (!c.out.empty())
+        {
+            ssize_t n = write(c.fd, c.out.data(), c.out.size());
+            if (n > 0)
+            {
+                c.out.erase(0, n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (n < 0 && errno == EINTR)
+                continue;
+            this->closeConnection(id);
+            return;
+        }
+
+        // stop reading once the peer has closed, or epoll keeps
+        // reporting the hangup while we finish its requests
+        unsigned events = (c.peerClosed ? 0 : EPOLLIN | EPOLLRDHUP) |
+                          (c.out.empty() ? 0 : EPOLLOUT);
+        if (events != c.events)
+        {
+            c.events = events;
+            this->watch(c.fd, events, EPOLL_CTL_MOD);
+        }
+
+        // the peer is done sending and has every response:
+        if (c.peerClosed && c.out.empty() && c.nextSend == c.nextSeq)
+            this->closeConnection(id);
+    }
+
+    //
+    // handleSignal
+    //
+    // Returns false if the server should stop.
+    //
+    bool handleSignal()
+    {
+        signalfd_siginfo info;
+        while (read(this->signalFd, &info, sizeof(info)) == sizeof(info))
+        {
+            if (info.ssi_signo != SIGHUP)
+                return false;
+            if (!this->maps.reload())
+                std::cerr << "reload: already in progress" << std::endl;
+        }
+        return true;
+    }
+
+    void drainCompletions()
+    {
+        uint64_t count;
+        ssize_t ignored = read(this->wakeFd, &count, sizeof(count));
+        (void)ignored;
+
+        std::vector<Completion> done;
+        {
+            std::lock_guard<std::mutex> guard(this->completionLock);
+            done.swap(this->completions);
+        }
+
+        std::vector<unsigned long long> touched;
+        for (Completion &c : done)
+        {
+            this->inFlight--;
+            this->served++;
+            this->latencies.add(c.Micros);
+
+            auto it = this->connections.find(c.Conn);
+            if (it == this->connections.end())
+                continue; // the client went away
+            this->complete(it->second, c.Seq, c.Response);
+            touched.push_back(c.Conn);
+        }
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (unsigned long long id : touched)
+            this->flushConnection(id);
+    }
+
+public:
+    Server(MapSnapshot &snapshot, int numThreads)
+        : maps(snapshot)
+    {
+        this->pool.reset(new WorkStealingPool(numThreads));
+        this->workspaces.resize(2 * this->pool->size());
+        for (SearchWorkspace &W : this->workspaces)
+            W.init(snapshot.acquire()->Graph.NumVertices());
+
+        this->epollFd = -1;
+        this->listenFd = -1;
+        this->wakeFd = -1;
+        this->signalFd = -1;
+        this->nextConnection = 0;
+        this->nextSession = 1;
+        this->inFlight = 0;
+        this->maxInFlight = 0;
+        this->served = 0;
+    }
+
+    ~Server()
+    {
+        // finish queued requests while everything they use still exists
+        this->pool.reset();
+
+        while (!this->connections.empty())
+            this->closeConnection(this->connections.begin()->first);
+        if (this->listenFd >= 0)
+            close(this->listenFd);
+        if (this->wakeFd >= 0)
+            close(this->wakeFd);
+        if (this->signalFd >= 0)
+            close(this->signalFd);
+        if (this->epollFd >= 0)
+            close(this->epollFd);
+    }
+
+    int run(const ServerOptions &options)
+    {
+        this->listenFd = openListener(options);
+        if (this->listenFd < 0)
+        {
+            std::cerr << "**Error: unable to listen: " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        sigset_t signals = shutdownSignals();
+        this->signalFd = signalfd(-1, &signals, SFD_NONBLOCK);
+        this->wakeFd = eventfd(0, EFD_NONBLOCK);
+        this->epollFd = epoll_create1(0);
+        if (this->signalFd < 0 || this->wakeFd < 0 || this->epollFd < 0)
+        {
+            std::cerr << "**Error: unable to start event loop." << std::endl;
+            return 1;
+        }
+
+        this->watch(this->listenFd, EPOLLIN, EPOLL_CTL_ADD);
+        this->watch(this->wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+        this->watch(this->signalFd, EPOLLIN, EPOLL_CTL_ADD);
+
+        if (options.TcpPort > 0)
+            std::cerr << "server: listening on 127.0.0.1:" << options.TcpPort;
+        else
+            std::cerr << "server: listening on " << options.SocketPath;
+        std::cerr << " with " << this->pool->size() << " worker(s)" << std::endl;
+
+        epoll_event events[64];
+        bool running = true;
+        Clock::time_point nextSweep = Clock::now() + std::chrono::milliseconds(SESSION_SWEEP_MS);
+
+        while (running)
+        {
+            int n = epoll_wait(this->epollFd, events, 64, SESSION_SWEEP_MS);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                break;
+
+            if (Clock::now() >= nextSweep)
+            {
+                this->sweepSessions();
+                nextSweep = Clock::now() + std::chrono::milliseconds(SESSION_SWEEP_MS);
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                int fd = events[i].data.fd;
+
+                if (fd == this->listenFd)
+                    this->acceptConnections();
+                else if (fd == this->wakeFd)
+                    this->drainCompletions();
+                else if (fd == this->signalFd)
+                    running = this->handleSignal();
+                else
+                {
+                    auto it = this->byFd.find(fd);
+                    if (it == this->byFd.end())
+                        continue;
+                    unsigned long long id = it->second;
+
+                    if (events[i].events & (EPOLLERR | EPOLLHUP))
+                        this->closeConnection(id);
+                    else if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+                        this->readConnection(id);
+                    else if (events[i].events & EPOLLOUT)
+                        this->flushConnection(id);
+                }
+            }
+        }
+
+        std::cerr << "server: shutting down after " << this->served << " request(s)" << std::endl;
+        if (options.TcpPort <= 0)
+            unlink(options.SocketPath.c_str());
+        return 0;
+    }
+};
+}
+
+//
+// runServer
+//
+int runServer(MapSnapshot &maps, const ServerOptions &options)
+{
+    sigset_t signals = shutdownSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Server server(maps, options.Threads > 0 ? options.Threads : defaultThreadCount());
+    return server.run(options);
+}
+
+#endif
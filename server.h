@@ -0,0 +1,102 @@
+/*server.h*/
+
+//
+// Long-running routing server.
+//
+// The map is loaded once; clients then connect over a Unix domain
+// socket (or TCP on localhost) and send one request per line.  Every
+// request gets exactly one response line, and responses on a
+// connection come back in request order, so a client may pipeline as
+// many requests as it likes without waiting.  Each request is answered
+// on the map and closures as they were when it was read, so a CLOSE,
+// OPEN or RELOAD pipelined behind it does not change its answer.
+// Fields are separated by tabs:
+//
+//   ROUTE <from> <to> [<metric>]
+//                       -> OK <miles> <node ids, space-separated>
+//                          the route that is shortest under the named
+//                          weighting (metrics.h; needs --cch), though
+//                          <miles> is always its walking length
+//   SNAP <lat> <lon>    -> OK <node id> <lat> <lon>
+//   LOOKUP <building>   -> OK <fullname> <abbrev> <lat> <lon> <node id>
+//   REACHABLE <from> <miles>
+//                       -> OK <node ids within the distance, nearest first>
+//   ISOCHRONE <from> <miles>
+//                       -> OK <nodes reached> <boundary "lat,lon" points,
+//                             space-separated, counter-clockwise>
+//   ALTERNATIVES <from> <to> <k> [yen|plateau]
+//                       -> OK <searches run> then, per route, shortest
+//                             first: <miles> <node ids, space-separated>
+//   TOUR <open|round> <stop> <stop> ...
+//                       -> OK <miles> <visiting order, as 0-based stop
+//                             indices> <node ids, space-separated>
+//   NEAREST <from> <category>
+//                       -> OK <fullname> <abbrev> <miles> <node ids>
+//                          of the closest building whose name contains
+//                          category, or with tag category ("key=value")
+//   STATS               -> OK requests=.. queue=.. max_queue=..
+//                             p50_us=.. p90_us=.. p99_us=.. max_us=..
+//                             generation=.. reloading=..
+//   RELOAD              -> OK reloading
+//   CLOSE <node> [<node>]
+//   OPEN <node> [<node>]  -> OK segments=.. nodes=..
+//                          closes or reopens the footway segment between
+//                          two adjacent nodes, or a node (see closures.h);
+//                          ROUTE, NEAREST, REACHABLE, ISOCHRONE,
+//                          ALTERNATIVES and TOUR avoid closures
+//   SESSION <from> <to> -> OK <session> <miles> <node ids>
+//   MOVE <session> <location>
+//   MOVE <session> <lat> <lon>
+//                       -> OK <miles> <node ids>
+//                          the route from the walker's new position,
+//                          replanned with D* Lite (dstarlite.h) from the
+//                          search the session kept, honoring closures
+//   END <session>       -> OK
+//
+// Failures answer "ERR <reason>".  Requests are parsed on a single
+// epoll event loop and answered on a work-stealing pool, one
+// SearchWorkspace per worker.  SIGINT / SIGTERM stop the server.
+//
+// A session is dropped by END, or after ten minutes without a request.
+// At most 1024 are open at once, and fewer on a big map: each keeps 20
+// bytes per map vertex, and all of them together at most 256 MB (about
+// 90 sessions on a map of 140,000 vertices).  SESSION answers "ERR too
+// many sessions" beyond that.
+// After a reload it lets go of the old map within a second, and its
+// next MOVE starts it over on the new one, keeping the destination by
+// OSM node id.
+// Its requests should be sent one at a time: pipelined MOVEs for one
+// session may be replanned in either order.
+//
+// RELOAD (or SIGHUP) re-reads the map file in the background while
+// queries keep running on the current snapshot; see snapshot.h.
+//
+// Server mode needs Linux (epoll, eventfd, signalfd).
+//
+
+#pragma once
+
+#include <string>
+
+#include "snapshot.h"
+
+struct ServerOptions
+{
+    std::string SocketPath; // Unix domain socket to listen on, or
+    int TcpPort;            // > 0 to listen on 127.0.0.1:TcpPort instead
+    int Threads;            // <= 0 means one per core
+
+    ServerOptions()
+    {
+        TcpPort = 0;
+        Threads = 0;
+    }
+};
+
+//
+// runServer
+//
+// Serves requests until interrupted.  Returns 0 on a clean shutdown,
+// non-zero if the server could not start.
+//
+int runServer(MapSnapshot &maps, const ServerOptions &options);
@@ -0,0 +1,285 @@
+/*simplify.cpp*/
+
+//
+// Degree-2 chain contraction.
+//
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "simplify.h"
+#include "sptcache.h"
+
+//
+// otherArc
+//
+// For a degree-2 vertex v, the edge leaving v that does not lead back
+// to prev.
+//
+static int otherArc(const CompactGraph &G, int v, int prev)
+{
+    int first = G.Offsets[v];
+    return (G.Targets[first] == prev) ? first + 1 : first;
+}
+
+//
+// simplifyGraph
+//
+void simplifyGraph(const CompactGraph &G, SimplifiedGraph &S)
+{
+    S = SimplifiedGraph();
+
+    int n = G.NumVertices();
+    std::vector<char> core(n, 0);
+    for (int v = 0; v < n; ++v)
+        core[v] = (G.Offsets[v + 1] - G.Offsets[v] != 2);
+
+    //
+    // a loop made only of degree-2 vertices has no core vertex to
+    // start from; promote the first vertex of every such loop:
+    //
+    std::vector<char> visited(n, 0);
+    for (int v = 0; v < n; ++v)
+    {
+        if (core[v] || visited[v])
+            continue;
+
+        visited[v] = 1;
+        for (int side = 0; side < 2; ++side)
+        {
+            int prev = v;
+            int cur = G.Targets[G.Offsets[v] + side];
+            while (!core[cur] && cur != v)
+            {
+                visited[cur] = 1;
+                int next = G.Targets[otherArc(G, cur, prev)];
+                prev = cur;
+                cur = next;
+            }
+
+            if (cur == v)
+            {
+                core[v] = 1;
+                break;
+            }
+        }
+    }
+
+    //
+    // core vertices keep their relative order:
+    //
+    S.BaseToCore.assign(n, -1);
+    for (int v = 0; v < n; ++v)
+    {
+        if (!core[v])
+            continue;
+
+        S.BaseToCore[v] = (int)S.CoreToBase.size();
+        S.CoreToBase.push_back(v);
+        S.Core.Index.emplace(G.IDs[v], S.BaseToCore[v]);
+        S.Core.IDs.push_back(G.IDs[v]);
+        S.Core.Lat.push_back(G.Lat[v]);
+        S.Core.Lon.push_back(G.Lon[v]);
+    }
+
+    //
+    // one core edge per edge leaving a core vertex: follow it through
+    // the degree-2 vertices to the next core vertex.  Every chain is
+    // walked once from each end; its vertices are filed under the
+    // first walk.
+    //
+    int numCore = S.Core.NumVertices();
+    S.Core.Offsets.assign(numCore + 1, 0);
+    S.ShapeOffsets.push_back(0);
+    S.ChainEdge.assign(n, -1);
+    S.ChainPos.assign(n, -1);
+    S.ChainDist.assign(n, 0.0);
+
+    for (int c = 0; c < numCore; ++c)
+    {
+        int u = S.CoreToBase[c];
+        for (int a = G.Offsets[u]; a < G.Offsets[u + 1]; ++a)
+        {
+            int e = S.Core.NumEdges();
+            int pos = 0;
+            int prev = u;
+            int cur = G.Targets[a];
+            double dist = G.Weights[a];
+
+            while (!core[cur])
+            {
+                S.Shape.push_back(cur);
+                if (S.ChainEdge[cur] == -1)
+                {
+                    S.ChainEdge[cur] = e;
+                    S.ChainPos[cur] = pos;
+                    S.ChainDist[cur] = dist;
+                }
+                pos++;
+
+                int next = otherArc(G, cur, prev);
+                dist += G.Weights[next];
+                prev = cur;
+                cur = G.Targets[next];
+            }
+
+            S.Core.Targets.push_back(S.BaseToCore[cur]);
+            S.Core.Weights.push_back(dist);
+            S.Core.Offsets[c + 1]++;
+            S.EdgeTail.push_back(c);
+            S.ShapeOffsets.push_back((int)S.Shape.size());
+        }
+    }
+
+    for (int c = 0; c < numCore; ++c)
+        S.Core.Offsets[c + 1] += S.Core.Offsets[c];
+}
+
+//
+// appendShape
+//
+// Appends the interior of the lightest core edge from p to q; that is
+// the edge the search relaxed, since a relaxation must be strictly
+// shorter to take effect.
+//
+static void appendShape(const SimplifiedGraph &S, int p, int q, std::vector<int> &path)
+{
+    int best = -1;
+    for (int e = S.Core.Offsets[p]; e < S.Core.Offsets[p + 1]; ++e)
+        if (S.Core.Targets[e] == q && (best < 0 || S.Core.Weights[e] < S.Core.Weights[best]))
+            best = e;
+
+    path.insert(path.end(), S.Shape.begin() + S.ShapeOffsets[best],
+                S.Shape.begin() + S.ShapeOffsets[best + 1]);
+}
+
+//
+// appendChain
+//
+// Appends the Shape positions of core edge e from "from" to "to"
+// (inclusive, either direction).
+//
+static void appendChain(const SimplifiedGraph &S, int e, int from, int to, std::vector<int> &path)
+{
+    int step = (from <= to) ? 1 : -1;
+    for (int p = from; p != to + step; p += step)
+        path.push_back(S.Shape[S.ShapeOffsets[e] + p]);
+}
+
+//
+// simplifiedRoute
+//
+bool simplifiedRoute(const CompactGraph &G, const SimplifiedGraph &S,
+                     int source, int target, SearchWorkspace &W,
+                     std::vector<int> &path, double &miles,
+                     QueueKind queue)
+{
+    path.clear();
+    miles = 0.0;
+
+    if (source == target)
+    {
+        path.push_back(source);
+        return true;
+    }
+
+    //
+    // a contracted source enters the core at both ends of its chain;
+    // the graph is symmetric, so the way back to the tail is as long
+    // as the way from it:
+    //
+    std::vector<SearchSeed> seeds;
+    int sc = S.BaseToCore[source];
+    int se = S.ChainEdge[source];
+    if (sc >= 0)
+        seeds.push_back(SearchSeed(sc, 0.0));
+    else
+    {
+        seeds.push_back(SearchSeed(S.EdgeTail[se], S.ChainDist[source]));
+        seeds.push_back(SearchSeed(S.Core.Targets[se], S.Core.Weights[se] - S.ChainDist[source]));
+    }
+
+    // likewise a contracted target is reached through either end
+    std::vector<int> targets;
+    double offsets[2] = {0.0, 0.0};
+    int tc = S.BaseToCore[target];
+    int te = S.ChainEdge[target];
+    if (tc >= 0)
+        targets.push_back(tc);
+    else
+    {
+        targets.push_back(S.EdgeTail[te]);
+        targets.push_back(S.Core.Targets[te]);
+        offsets[0] = S.ChainDist[target];
+        offsets[1] = S.Core.Weights[te] - S.ChainDist[target];
+    }
+
+    dijkstraSearch(S.Core, seeds, W, targets, queue);
+
+    double best = INF_DIST;
+    int side = -1;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        if (W.Settled[targets[i]] && W.Dist[targets[i]] + offsets[i] < best)
+        {
+            best = W.Dist[targets[i]] + offsets[i];
+            side = (int)i;
+        }
+    }
+
+    // both on the same chain: maybe no need to leave it at all
+    if (sc < 0 && tc < 0 && se == te &&
+        std::fabs(S.ChainDist[source] - S.ChainDist[target]) <= best)
+    {
+        appendChain(S, se, S.ChainPos[source], S.ChainPos[target], path);
+        miles = pathLength(G, path);
+        return true;
+    }
+
+    if (side < 0)
+        return false;
+
+    std::vector<int> corePath;
+    for (int c = targets[side]; c != -1; c = W.Pred[c])
+        corePath.push_back(c);
+    std::reverse(corePath.begin(), corePath.end());
+
+    //
+    // expand: the piece of the source's chain up to the core vertex
+    // the search started from, then every core edge, then the piece
+    // of the target's chain:
+    //
+    if (sc < 0)
+    {
+        int tail = S.EdgeTail[se];
+        int head = S.Core.Targets[se];
+        int last = S.ShapeOffsets[se + 1] - S.ShapeOffsets[se] - 1;
+        bool towardTail = (corePath[0] == tail &&
+                           (tail != head || seeds[0].Dist <= seeds[1].Dist));
+
+        if (towardTail)
+            appendChain(S, se, S.ChainPos[source], 0, path);
+        else
+            appendChain(S, se, S.ChainPos[source], last, path);
+    }
+
+    for (size_t i = 0; i < corePath.size(); ++i)
+    {
+        if (i > 0)
+            appendShape(S, corePath[i - 1], corePath[i], path);
+        path.push_back(S.CoreToBase[corePath[i]]);
+    }
+
+    if (tc < 0)
+    {
+        int last = S.ShapeOffsets[te + 1] - S.ShapeOffsets[te] - 1;
+        if (side == 0)
+            appendChain(S, te, 0, S.ChainPos[target], path);
+        else
+            appendChain(S, te, last, S.ChainPos[target], path);
+    }
+
+    miles = pathLength(G, path);
+    return true;
+}
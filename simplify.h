@@ -0,0 +1,77 @@
+/*simplify.h*/
+
+//
+// Degree-2 chain contraction.
+//
+// Footways are drawn with many shape nodes, and every one of them is
+// a vertex of the compact graph with exactly two neighbors.  A search
+// gains nothing from stopping at those: it can only go on to the
+// other neighbor.  The simplified graph keeps only the "core"
+// vertices -- dead ends, junctions, and one vertex of every isolated
+// loop -- and replaces each chain of degree-2 vertices between two
+// core vertices by a single edge whose weight is the chain's length.
+//
+// The contracted vertices are not lost: every core edge remembers the
+// chain it stands for (its "shape"), so a route found on the core can
+// be expanded back into the full list of footway nodes, and a query
+// that starts or ends in the middle of a chain enters the core at the
+// two ends of that chain.
+//
+//   Core                  the contracted graph (core vertices only)
+//   CoreToBase[c]         compact-graph vertex of core vertex c
+//   BaseToCore[v]         core vertex of v, or -1 if v was contracted
+//   EdgeTail[e]           tail of core edge e (Core.Targets[e] is its head)
+//   ShapeOffsets[e] .. ShapeOffsets[e+1]-1
+//                         index the interior vertices of e in Shape,
+//                         in order from tail to head
+//
+// A contracted vertex v lies on the chain of core edge ChainEdge[v],
+// at Shape position ChainPos[v], ChainDist[v] miles from its tail.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "compactgraph.h"
+#include "search.h"
+
+struct SimplifiedGraph
+{
+    CompactGraph Core;
+    std::vector<int> CoreToBase;
+    std::vector<int> BaseToCore;
+    std::vector<int> EdgeTail;
+    std::vector<int> ShapeOffsets; // size Core.NumEdges()+1
+    std::vector<int> Shape;        // base vertices
+    std::vector<int> ChainEdge;    // per base vertex, -1 for core vertices
+    std::vector<int> ChainPos;
+    std::vector<double> ChainDist;
+
+    bool empty() const
+    {
+        return this->CoreToBase.empty();
+    }
+};
+
+//
+// simplifyGraph
+//
+// Contracts the degree-2 chains of G (which must be symmetric, as
+// buildCompactGraph makes it) into S.  Shortest distances between
+// core vertices are the same in S.Core as in G.
+//
+void simplifyGraph(const CompactGraph &G, SimplifiedGraph &S);
+
+//
+// simplifiedRoute
+//
+// Shortest path from source to target (vertices of G) found by
+// searching S.Core, using the workspace W.  On success fills path
+// with the full list of G's vertices and miles with its length, and
+// returns true; returns false if target is unreachable.
+//
+bool simplifiedRoute(const CompactGraph &G, const SimplifiedGraph &S,
+                     int source, int target, SearchWorkspace &W,
+                     std::vector<int> &path, double &miles,
+                     QueueKind queue = QUEUE_DARY);
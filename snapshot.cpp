@@ -0,0 +1,90 @@
+/*snapshot.cpp*/
+
+//
+// Atomically replaceable map state.
+//
+
+#include <iostream>
+#include <chrono>
+
+#include "snapshot.h"
+
+MapSnapshot::~MapSnapshot()
+{
+    std::lock_guard<std::mutex> guard(this->reloaderLock);
+    if (this->reloader.joinable())
+        this->reloader.join();
+}
+
+bool MapSnapshot::reload()
+{
+    bool expected = false;
+    if (!this->reloading.compare_exchange_strong(expected, true))
+        return false;
+
+    std::lock_guard<std::mutex> guard(this->reloaderLock);
+    if (this->reloader.joinable())
+        this->reloader.join(); // the previous reload, already finished
+    this->reloader = std::thread(&MapSnapshot::reloadInBackground, this);
+    return true;
+}
+
+bool MapSnapshot::setClosed(const std::vector<long long> &ids, bool closed)
+{
+    std::lock_guard<std::mutex> guard(this->closureLock);
+    Ptr campus = this->acquire();
+
+    // copy on write: queries may be reading the current set
+    std::shared_ptr<Closures> next = std::make_shared<Closures>(*currentClosures(*campus));
+    bool changed = false;
+    if (ids.size() == 2)
+        changed = setSegmentClosed(campus->Graph, *next, ids[0], ids[1], closed);
+    else if (ids.size() == 1)
+        changed = setNodeClosed(campus->Graph, *next, ids[0], closed);
+    if (!changed)
+        return false;
+
+    repairMetrics(*campus, *next);
+    publishClosures(*campus, next);
+    return true;
+}
+
+void MapSnapshot::reloadInBackground()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<CampusMap> next = std::make_shared<CampusMap>();
+    if (!loadCampusMap(this->filename, *next, this->options))
+    {
+        std::cerr << "reload: unable to load '" << this->filename
+                  << "', keeping the current map" << std::endl;
+        this->reloading = false;
+        return;
+    }
+
+    Ptr old;
+    {
+        // closures made meanwhile carry over to the new graph
+        std::lock_guard<std::mutex> guard(this->closureLock);
+        old = std::atomic_load(&this->current);
+
+        std::shared_ptr<Closures> closures = std::make_shared<Closures>();
+        closures->Segments = currentClosures(*old)->Segments;
+        closures->Nodes = currentClosures(*old)->Nodes;
+        applyClosures(next->Graph, *closures);
+        repairMetrics(*next, *closures);
+        next->Closed = closures;
+
+        std::atomic_store(&this->current, Ptr(next));
+    }
+    long long generation = ++this->generation;
+    this->reloading = false;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "reload: generation " << generation << " ("
+              << next->Graph.NumVertices() << " vertices) in "
+              << elapsed.count() << " s" << std::endl;
+
+    // whoever drops the last reference to the old snapshot frees it
+    old.reset();
+}
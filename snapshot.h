@@ -0,0 +1,115 @@
+/*snapshot.h*/
+
+//
+// Atomically replaceable map state, for reloading the map while the
+// server keeps answering queries.
+//
+// The routing state (nodes, buildings, lookup tables, compact graph)
+// lives in a CampusMap that is never modified once published.  A
+// query takes a reference to the current snapshot when it starts and
+// uses it to the end, so a reload never changes anything under a
+// running query.  A reload builds the new CampusMap on a background
+// thread, swaps the pointer in one atomic store and is done: the old
+// snapshot is freed by whoever drops the last reference to it, the
+// reloader itself if no query was still using it.
+//
+// Closures (closures.h) are the one thing that changes in place: each
+// snapshot holds an atomically replaceable pointer to its own set, and
+// a reload carries the current set over to the new snapshot.
+//
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "campus.h"
+
+class MapSnapshot
+{
+public:
+    typedef std::shared_ptr<const CampusMap> Ptr;
+
+private:
+    Ptr current; // only accessed through std::atomic_load / atomic_store
+    std::string filename;
+    LoadOptions options;
+    std::atomic<long long> generation;
+    std::atomic<bool> reloading;
+    std::thread reloader;
+    std::mutex reloaderLock;
+    std::mutex closureLock; // one closure change (or hand-over) at a time
+
+    void reloadInBackground();
+
+public:
+    MapSnapshot(const std::string &mapFile, const LoadOptions &loadOptions, Ptr initial)
+    {
+        this->filename = mapFile;
+        this->options = loadOptions;
+        this->generation = 1;
+        this->reloading = false;
+        std::atomic_store(&this->current, initial);
+    }
+
+    //
+    // destructor
+    //
+    // Waits for a reload in progress to finish.
+    //
+    ~MapSnapshot();
+
+    //
+    // acquire
+    //
+    // Returns the current snapshot; it stays valid for as long as the
+    // caller holds the pointer, even if a reload replaces it.
+    //
+    Ptr acquire() const
+    {
+        return std::atomic_load(&this->current);
+    }
+
+    //
+    // reload
+    //
+    // Starts rebuilding the snapshot from the map file in the
+    // background.  Returns false if a reload is already running.  If
+    // the file cannot be loaded the current snapshot stays in place.
+    //
+    bool reload();
+
+    //
+    // setClosed
+    //
+    // Closes (or reopens) the footway segment between two adjacent OSM
+    // nodes (ids has two entries) or a node (one entry) on the current
+    // snapshot.  Queries already running keep the closures they
+    // started with.  Returns false if there is no such segment or node.
+    //
+    bool setClosed(const std::vector<long long> &ids, bool closed);
+
+    //
+    // closures
+    //
+    // The closures of the current snapshot.
+    //
+    ClosuresPtr closures() const
+    {
+        return currentClosures(*this->acquire());
+    }
+
+    long long Generation() const
+    {
+        return this->generation.load();
+    }
+
+    bool Reloading() const
+    {
+        return this->reloading.load();
+    }
+};
@@ -0,0 +1,108 @@
+/*sptcache.cpp*/
+
+//
+// LRU cache of shortest-path trees, keyed by source vertex.
+//
+
+#include <vector>
+
+#include "sptcache.h"
+
+//
+// makeTree
+//
+std::shared_ptr<const ShortestPathTree> makeTree(int source, const SearchWorkspace &W)
+{
+    std::shared_ptr<ShortestPathTree> tree = std::make_shared<ShortestPathTree>();
+    tree->Source = source;
+    tree->Pred = W.Pred;
+    return tree;
+}
+
+//
+// pathLength
+//
+double pathLength(const CompactGraph &G, const std::vector<int> &path)
+{
+    double length = 0.0;
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        int u = path[i];
+        for (int e = G.Offsets[u]; e < G.Offsets[u + 1]; ++e)
+        {
+            if (G.Targets[e] == path[i + 1])
+            {
+                length += G.Weights[e];
+                break;
+            }
+        }
+    }
+    return length;
+}
+
+SptCache::TreePtr SptCache::find(int source)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    auto it = this->bySource.find(source);
+    if (it == this->bySource.end())
+    {
+        this->Misses++;
+        return TreePtr();
+    }
+
+    // move to the front of the LRU list:
+    this->lru.splice(this->lru.begin(), this->lru, it->second);
+    this->Hits++;
+    return *it->second;
+}
+
+void SptCache::insert(TreePtr tree)
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    size_t size = tree->bytes();
+    if (size > this->budget)
+        return;
+
+    auto it = this->bySource.find(tree->Source);
+    if (it != this->bySource.end())
+    {
+        this->used -= (*it->second)->bytes();
+        this->lru.erase(it->second);
+        this->bySource.erase(it);
+    }
+
+    while (!this->lru.empty() && this->used + size > this->budget)
+    {
+        TreePtr victim = this->lru.back();
+        this->used -= victim->bytes();
+        this->bySource.erase(victim->Source);
+        this->lru.pop_back();
+        this->Evictions++;
+    }
+
+    this->lru.push_front(tree);
+    this->bySource[tree->Source] = this->lru.begin();
+    this->used += size;
+}
+
+void SptCache::clear()
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->lru.clear();
+    this->bySource.clear();
+    this->used = 0;
+}
+
+size_t SptCache::bytesUsed() const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->used;
+}
+
+size_t SptCache::size() const
+{
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->lru.size();
+}
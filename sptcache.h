@@ -0,0 +1,111 @@
+/*sptcache.h*/
+
+//
+// LRU cache of shortest-path trees, keyed by source vertex.
+//
+// A full Dijkstra search from a source answers every query from that
+// source, so instead of throwing the tree away we keep the most
+// recently used ones, up to a memory budget.  A tree is stored
+// compactly as its predecessor array alone (4 bytes per vertex);
+// exact distances are recovered by summing edge weights along the
+// traced path, which repeats the additions Dijkstra made and therefore
+// gives the same double.
+//
+// The cache is safe to share between threads.  Trees are handed out
+// as shared pointers, so a tree evicted while in use stays valid for
+// whoever holds it.
+//
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#include "compactgraph.h"
+#include "search.h"
+
+struct ShortestPathTree
+{
+    int Source;
+    std::vector<int> Pred; // -1 for the source / unreachable vertices
+
+    ShortestPathTree()
+    {
+        Source = -1;
+    }
+
+    size_t bytes() const
+    {
+        return sizeof(*this) + this->Pred.size() * sizeof(int);
+    }
+};
+
+//
+// makeTree
+//
+// Copies a completed (untargeted) search out of a workspace.
+//
+std::shared_ptr<const ShortestPathTree> makeTree(int source, const SearchWorkspace &W);
+
+//
+// pathLength
+//
+// Sums the edge weights along path, in miles.
+//
+double pathLength(const CompactGraph &G, const std::vector<int> &path);
+
+class SptCache
+{
+private:
+    typedef std::shared_ptr<const ShortestPathTree> TreePtr;
+
+    size_t budget;
+    size_t used;
+    std::list<TreePtr> lru; // most recently used first
+    std::unordered_map<int, std::list<TreePtr>::iterator> bySource;
+    mutable std::mutex lock;
+
+public:
+    long long Hits;
+    long long Misses;
+    long long Evictions;
+
+    SptCache(size_t budgetBytes)
+    {
+        this->budget = budgetBytes;
+        this->used = 0;
+        this->Hits = 0;
+        this->Misses = 0;
+        this->Evictions = 0;
+    }
+
+    //
+    // find
+    //
+    // Returns the cached tree for source and marks it most recently
+    // used, or nullptr if it is not cached.
+    //
+    TreePtr find(int source);
+
+    //
+    // insert
+    //
+    // Adds a tree, evicting least recently used trees until the cache
+    // fits its budget.  A tree larger than the whole budget is not
+    // cached.
+    //
+    void insert(TreePtr tree);
+
+    //
+    // clear
+    //
+    // Drops every cached tree.
+    //
+    void clear();
+
+    size_t bytesUsed() const;
+    size_t size() const;
+};
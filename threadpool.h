@@ -0,0 +1,204 @@
+/*threadpool.h*/
+
+//
+// Work-stealing thread pool.
+//
+// Every worker owns a deque of tasks.  A worker takes work from the
+// back of its own deque (most recently pushed, still warm in cache)
+// and, when that is empty, steals from the front of another worker's
+// deque, so a worker that drew a run of cheap queries keeps itself
+// busy with the expensive ones left elsewhere.
+//
+// Tasks receive the index of the worker running them, which callers
+// use to pick per-worker state (e.g. one SearchWorkspace per worker)
+// without any locking.
+//
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+//
+// defaultThreadCount
+//
+// Number of worker threads to use when the caller does not say.
+//
+inline int defaultThreadCount()
+{
+    int n = (int)std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+class WorkStealingPool
+{
+public:
+    typedef std::function<void(int worker)> Task;
+
+private:
+    struct Worker
+    {
+        std::deque<Task> tasks;
+        std::mutex lock;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<int> pending; // queued, not yet started
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+    std::mutex sleepLock;
+    std::condition_variable wakeup;
+
+    bool popLocal(int me, Task &task)
+    {
+        Worker &w = *this->workers[me];
+        std::lock_guard<std::mutex> guard(w.lock);
+        if (w.tasks.empty())
+            return false;
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int me, Task &task)
+    {
+        int n = (int)this->workers.size();
+        for (int i = 1; i < n; ++i)
+        {
+            Worker &victim = *this->workers[(me + i) % n];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.tasks.empty())
+                continue;
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void run(int me)
+    {
+        while (true)
+        {
+            Task task;
+            if (this->popLocal(me, task) || this->steal(me, task))
+            {
+                this->pending--;
+                task(me);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(this->sleepLock);
+            if (this->stopping)
+                return;
+            this->wakeup.wait(guard, [this]() {
+                return this->stopping || this->pending > 0;
+            });
+        }
+    }
+
+public:
+    //
+    // constructor
+    //
+    // Starts numThreads workers (at least one).
+    //
+    WorkStealingPool(int numThreads)
+    {
+        if (numThreads < 1)
+            numThreads = 1;
+
+        this->pending = 0;
+        this->nextQueue = 0;
+        this->stopping = false;
+
+        for (int i = 0; i < numThreads; ++i)
+            this->workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for (int i = 0; i < numThreads; ++i)
+            this->threads.push_back(std::thread(&WorkStealingPool::run, this, i));
+    }
+
+    //
+    // destructor
+    //
+    // Finishes every queued task, then joins the workers.
+    //
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->stopping = true;
+        }
+        this->wakeup.notify_all();
+        for (std::thread &t : this->threads)
+            t.join();
+    }
+
+    int size() const
+    {
+        return (int)this->workers.size();
+    }
+
+    //
+    // submit
+    //
+    // Queues a task; tasks are dealt round-robin over the workers'
+    // deques and rebalanced by stealing.
+    //
+    void submit(Task task)
+    {
+        int n = (int)this->workers.size();
+        Worker &w = *this->workers[this->nextQueue++ % n];
+        {
+            std::lock_guard<std::mutex> guard(w.lock);
+            w.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->pending++;
+        }
+        this->wakeup.notify_one();
+    }
+
+    //
+    // parallelFor
+    //
+    // Runs body(begin, end, worker) over [0, count) split into chunks
+    // of at most grain items, and returns when every chunk is done.
+    // Must not be called from inside a task.
+    //
+    void parallelFor(size_t count, size_t grain,
+                     const std::function<void(size_t, size_t, int)> &body)
+    {
+        if (grain < 1)
+            grain = 1;
+
+        std::mutex doneLock;
+        std::condition_variable done;
+        size_t remaining = (count + grain - 1) / grain;
+        if (remaining == 0)
+            return;
+
+        for (size_t begin = 0; begin < count; begin += grain)
+        {
+            size_t end = (begin + grain < count) ? begin + grain : count;
+            this->submit([&, begin, end](int worker) {
+                body(begin, end, worker);
+
+                std::lock_guard<std::mutex> guard(doneLock);
+                if (--remaining == 0)
+                    done.notify_all();
+            });
+        }
+
+        std::unique_lock<std::mutex> guard(doneLock);
+        done.wait(guard, [&remaining]() { return remaining == 0; });
+    }
+};
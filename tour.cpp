@@ -0,0 +1,240 @@
+/*tour.cpp*/
+
+//
+// Multi-stop tours: visit a set of buildings in a short order.
+//
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "tour.h"
+#include "search.h" // INF_DIST
+
+// moves must gain at least this much, so rounding cannot cycle
+static const double MIN_GAIN = 1e-9;
+
+//
+// heldKarp
+//
+// best[mask][j]: the shortest way from stop 0 through the stops in
+// mask (bit j-1 for stop j) ending at stop j.
+//
+static void heldKarp(const DistanceMatrix &M, TourKind kind, std::vector<int> &order)
+{
+    int n = M.N;
+    int rest = n - 1;
+    size_t numMasks = (size_t)1 << rest;
+
+    std::vector<double> best(numMasks * n, INF_DIST);
+    std::vector<signed char> prev(numMasks * n, -1);
+    for (int j = 1; j < n; ++j)
+        best[((size_t)1 << (j - 1)) * n + j] = M.at(0, j);
+
+    for (size_t mask = 1; mask < numMasks; ++mask)
+    {
+        for (int j = 1; j < n; ++j)
+        {
+            double here = best[mask * n + j];
+            if (!(mask & ((size_t)1 << (j - 1))) || here == INF_DIST)
+                continue;
+
+            for (int k = 1; k < n; ++k)
+            {
+                size_t bit = (size_t)1 << (k - 1);
+                if (mask & bit)
+                    continue;
+                double d = here + M.at(j, k);
+                size_t next = (mask | bit) * n + k;
+                if (d < best[next])
+                {
+                    best[next] = d;
+                    prev[next] = (signed char)j;
+                }
+            }
+        }
+    }
+
+    size_t full = numMasks - 1;
+    int last = 1;
+    double shortest = INF_DIST;
+    for (int j = 1; j < n; ++j)
+    {
+        double d = best[full * n + j] + (kind == TOUR_ROUND_TRIP ? M.at(j, 0) : 0.0);
+        if (d < shortest)
+        {
+            shortest = d;
+            last = j;
+        }
+    }
+
+    order.assign(n, 0);
+    size_t mask = full;
+    for (int i = n - 1; i >= 1; --i)
+    {
+        order[i] = last;
+        int before = prev[mask * n + last];
+        mask &= ~((size_t)1 << (last - 1));
+        last = before;
+    }
+}
+
+//
+// improveTour
+//
+// Nearest neighbor, then 2-opt and Or-opt to a local optimum.
+//
+static void improveTour(const DistanceMatrix &M, TourKind kind, std::vector<int> &order)
+{
+    int n = M.N;
+
+    std::vector<char> visited(n, 0);
+    order.assign(1, 0);
+    visited[0] = 1;
+    while ((int)order.size() < n)
+    {
+        int from = order.back();
+        int nearest = -1;
+        for (int j = 0; j < n; ++j)
+            if (!visited[j] && (nearest < 0 || M.at(from, j) < M.at(from, nearest)))
+                nearest = j;
+        visited[nearest] = 1;
+        order.push_back(nearest);
+    }
+
+    //
+    // seq is the order followed by an END marker (n): leaving for END
+    // costs nothing on an open tour and the way home on a round trip,
+    // so both kinds are the same fixed-ends path problem.
+    //
+    std::vector<int> seq = order;
+    seq.push_back(n);
+    auto cost = [&](int a, int b) {
+        if (b == n)
+            return kind == TOUR_ROUND_TRIP ? M.at(a, 0) : 0.0;
+        return M.at(a, b);
+    };
+
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+
+        // 2-opt: reverse seq[i..j] (distances are symmetric)
+        for (int i = 1; i < n - 1; ++i)
+        {
+            for (int j = i + 1; j < n; ++j)
+            {
+                double delta = cost(seq[i - 1], seq[j]) + cost(seq[i], seq[j + 1]) -
+                               cost(seq[i - 1], seq[i]) - cost(seq[j], seq[j + 1]);
+                if (delta < -MIN_GAIN)
+                {
+                    std::reverse(seq.begin() + i, seq.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+
+        // Or-opt: move seq[i..i+len-1] between seq[p] and seq[p+1]
+        for (int len = 1; len <= 3; ++len)
+        {
+            for (int i = 1; i + len <= n; ++i)
+            {
+                int first = seq[i];
+                int last = seq[i + len - 1];
+                double removed = cost(seq[i - 1], first) + cost(last, seq[i + len]) -
+                                 cost(seq[i - 1], seq[i + len]);
+
+                for (int p = 0; p < n; ++p)
+                {
+                    if (p >= i - 1 && p < i + len)
+                        continue; // an edge touching the run
+                    double forward = cost(seq[p], first) + cost(last, seq[p + 1]) - cost(seq[p], seq[p + 1]);
+                    double backward = cost(seq[p], last) + cost(first, seq[p + 1]) - cost(seq[p], seq[p + 1]);
+                    double added = std::min(forward, backward);
+                    if (added - removed >= -MIN_GAIN)
+                        continue;
+
+                    std::vector<int> run(seq.begin() + i, seq.begin() + i + len);
+                    if (backward < forward)
+                        std::reverse(run.begin(), run.end());
+                    seq.erase(seq.begin() + i, seq.begin() + i + len);
+                    int at = (p < i ? p + 1 : p + 1 - len);
+                    seq.insert(seq.begin() + at, run.begin(), run.end());
+                    improved = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    seq.pop_back();
+    order = seq;
+}
+
+//
+// orderStops
+//
+bool orderStops(const DistanceMatrix &M, TourKind kind, std::vector<int> &order)
+{
+    if (M.N <= 2)
+    {
+        order.clear();
+        for (int i = 0; i < M.N; ++i)
+            order.push_back(i);
+        return true;
+    }
+
+    if (M.N <= HELD_KARP_MAX_STOPS)
+    {
+        heldKarp(M, kind, order);
+        return true;
+    }
+
+    improveTour(M, kind, order);
+    return false;
+}
+
+//
+// planTour
+//
+bool planTour(const CampusMap &campus, const std::vector<int> &stops, TourKind kind,
+              int numThreads, TourPlan &plan, const Closures *closed)
+{
+    plan = TourPlan();
+    if (stops.empty())
+        return true;
+
+    auto start = std::chrono::steady_clock::now();
+    DistanceMatrix M;
+    if (!campus.Labels.Parents.empty() && !closed)
+        labelDistanceMatrix(campus.Labels, stops, M, true);
+    else
+        computeDistanceMatrix(campus.Graph, stops, M, true, numThreads, closed);
+    auto tabled = std::chrono::steady_clock::now();
+
+    for (double d : M.Dist)
+        if (d == INF_DIST)
+            return false;
+
+    plan.Exact = orderStops(M, kind, plan.Order);
+    auto ordered = std::chrono::steady_clock::now();
+
+    std::vector<int> legs = plan.Order;
+    if (kind == TOUR_ROUND_TRIP)
+        legs.push_back(0);
+
+    plan.Path.push_back(stops[0]);
+    for (size_t i = 0; i + 1 < legs.size(); ++i)
+    {
+        const std::vector<int> &leg = M.Paths[(size_t)legs[i] * M.N + legs[i + 1]];
+        plan.Path.insert(plan.Path.end(), leg.begin() + 1, leg.end());
+        plan.Miles += M.at(legs[i], legs[i + 1]);
+    }
+
+    std::chrono::duration<double> table = tabled - start;
+    std::chrono::duration<double> choose = ordered - tabled;
+    plan.TableSeconds = table.count();
+    plan.OrderSeconds = choose.count();
+    return true;
+}
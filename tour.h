@@ -0,0 +1,73 @@
+/*tour.h*/
+
+//
+// Multi-stop tours: visit a set of buildings in a short order.
+//
+// The stop-to-stop distances and paths come from one distance matrix
+// (matrix.h; from the hub labels when they were built with paths and
+// no closures are active).
+// The visiting order is then a small travelling-salesman problem over
+// that table, with no further searches:
+//
+//   - up to HELD_KARP_MAX_STOPS stops, Held-Karp dynamic programming
+//     finds the best order exactly, in O(2^n n^2) steps;
+//   - beyond that, a nearest-neighbor tour is improved by 2-opt
+//     (reversing a stretch) and Or-opt (moving a run of up to three
+//     stops elsewhere, either way round) until neither helps.
+//
+// The tour starts at the first stop; a round trip also ends there.
+// The route itself is the table's stop-to-stop paths joined end to end.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "campus.h"
+#include "matrix.h"
+
+const int HELD_KARP_MAX_STOPS = 13;
+
+enum TourKind
+{
+    TOUR_OPEN,      // ends at whichever stop is best
+    TOUR_ROUND_TRIP // returns to the first stop
+};
+
+struct TourPlan
+{
+    std::vector<int> Order; // indices into the stops, in visiting order, first stop first
+    std::vector<int> Path;  // dense vertices of the whole tour
+    double Miles;
+    bool Exact;             // the order is optimal (Held-Karp)
+    double TableSeconds;    // time to build the distance table
+    double OrderSeconds;    // time to choose the order
+
+    TourPlan()
+    {
+        Miles = 0.0;
+        Exact = false;
+        TableSeconds = 0.0;
+        OrderSeconds = 0.0;
+    }
+};
+
+//
+// orderStops
+//
+// The visiting order of M's endpoints, starting at endpoint 0, by
+// Held-Karp or the heuristics depending on M.N.  Returns true if the
+// order is exact.  Every distance in M must be finite.
+//
+bool orderStops(const DistanceMatrix &M, TourKind kind, std::vector<int> &order);
+
+//
+// planTour
+//
+// Plans a tour of stops (dense vertices; numThreads as for the
+// distance matrix), avoiding closed, if given.  Returns false if some
+// stop cannot reach another.  The hub labels know nothing of closures,
+// so while any are active the table comes from searches.
+//
+bool planTour(const CampusMap &campus, const std::vector<int> &stops, TourKind kind,
+              int numThreads, TourPlan &plan, const Closures *closed = nullptr);
@@ -0,0 +1,104 @@
+/*writer.h*/
+
+//
+// Buffered text output for machine-readable results.
+//
+// iostreams with std::endl flush on every line, which dominates the
+// cost of printing millions of short records.  BufferedWriter formats
+// into its own buffer and hands the bytes to stdio only when the
+// buffer fills (or on flush / destruction).
+//
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class BufferedWriter
+{
+private:
+    std::FILE *out;
+    std::vector<char> buffer;
+    size_t used;
+
+    void drain()
+    {
+        if (this->used > 0)
+            std::fwrite(this->buffer.data(), 1, this->used, this->out);
+        this->used = 0;
+    }
+
+    void reserve(size_t n)
+    {
+        if (this->used + n > this->buffer.size())
+            this->drain();
+        if (n > this->buffer.size())
+            this->buffer.resize(n);
+    }
+
+public:
+    BufferedWriter(std::FILE *output, size_t capacity = 1 << 16)
+    {
+        this->out = output;
+        this->buffer.resize(capacity);
+        this->used = 0;
+    }
+
+    ~BufferedWriter()
+    {
+        this->flush();
+    }
+
+    void flush()
+    {
+        this->drain();
+        std::fflush(this->out);
+    }
+
+    BufferedWriter &put(char c)
+    {
+        this->reserve(1);
+        this->buffer[this->used++] = c;
+        return *this;
+    }
+
+    BufferedWriter &put(const char *s, size_t n)
+    {
+        this->reserve(n);
+        std::memcpy(this->buffer.data() + this->used, s, n);
+        this->used += n;
+        return *this;
+    }
+
+    BufferedWriter &put(const char *s)
+    {
+        return this->put(s, std::strlen(s));
+    }
+
+    BufferedWriter &put(const std::string &s)
+    {
+        return this->put(s.data(), s.size());
+    }
+
+    BufferedWriter &put(long long x)
+    {
+        this->reserve(24);
+        this->used += std::snprintf(this->buffer.data() + this->used, 24, "%lld", x);
+        return *this;
+    }
+
+    //
+    // put(double)
+    //
+    // Writes x with 8 significant digits, the precision the
+    // interactive output uses.
+    //
+    BufferedWriter &put(double x)
+    {
+        this->reserve(32);
+        this->used += std::snprintf(this->buffer.data() + this->used, 32, "%.8g", x);
+        return *this;
+    }
+};